@@ -57,6 +57,8 @@ call is efficient.
 
 import enum
 import collections
+import hashlib
+import os
 
 from ctypes import *
 from pathlib import Path
@@ -1374,6 +1376,12 @@ class Cursor(Structure):
 
     _fields_ = [("_kind_id", c_int), ("xdata", c_int), ("data", c_void_p * 3)]
 
+    # Cursors are created by the million when walking large ASTs, so they do
+    # not carry an instance dict. Besides the owning translation unit only the
+    # properties that are read over and over while traversing get a cache
+    # slot; everything else is a direct native call.
+    __slots__ = ("_tu", "_spelling", "_loc", "_extent", "_type", "_hash", "_parent")
+
     @staticmethod
     def from_location(tu, location):
         # We store a reference to the TU in the instance so the TU won't get
@@ -1511,20 +1519,12 @@ class Cursor(Structure):
         cursor, such as the parameters of a function or template or the
         arguments of a class template specialization.
         """
-        if not hasattr(self, "_displayname"):
-            self._displayname = conf.lib.clang_getCursorDisplayName(
-                self
-            )
-        return self._displayname
+        return conf.lib.clang_getCursorDisplayName(self)
 
     @property
     def mangled_name(self):
         """Return the mangled name for the entity referenced by this cursor."""
-        if not hasattr(self, "_mangled_name"):
-            self._mangled_name = conf.lib.clang_Cursor_getMangling(
-                self
-            )
-        return self._mangled_name
+        return conf.lib.clang_Cursor_getMangling(self)
 
     @property
     def location(self):
@@ -1540,18 +1540,12 @@ class Cursor(Structure):
     @property
     def linkage(self):
         """Return the linkage of this cursor."""
-        if not hasattr(self, "_linkage"):
-            self._linkage = conf.lib.clang_getCursorLinkage(self)
-
-        return LinkageKind.from_id(self._linkage)
+        return LinkageKind.from_id(conf.lib.clang_getCursorLinkage(self))
 
     @property
     def tls_kind(self):
         """Return the thread-local storage (TLS) kind of this cursor."""
-        if not hasattr(self, "_tls_kind"):
-            self._tls_kind = conf.lib.clang_getCursorTLSKind(self)
-
-        return TLSKind.from_id(self._tls_kind)
+        return TLSKind.from_id(conf.lib.clang_getCursorTLSKind(self))
 
     @property
     def extent(self):
@@ -1570,126 +1564,78 @@ class Cursor(Structure):
         Retrieves the storage class (if any) of the entity pointed at by the
         cursor.
         """
-        if not hasattr(self, "_storage_class"):
-            self._storage_class = conf.lib.clang_Cursor_getStorageClass(self)
-
-        return StorageClass.from_id(self._storage_class)
+        return StorageClass.from_id(conf.lib.clang_Cursor_getStorageClass(self))
 
     @property
     def availability(self):
         """
         Retrieves the availability of the entity pointed at by the cursor.
         """
-        if not hasattr(self, "_availability"):
-            self._availability = conf.lib.clang_getCursorAvailability(self)
-
-        return AvailabilityKind.from_id(self._availability)
+        return AvailabilityKind.from_id(conf.lib.clang_getCursorAvailability(self))
 
     @property
     def literal(self):
         """
         Retrieves the literal at this cursor
         """
-        if not hasattr(self, "_literal"):
-            self._literal = conf.sealang.clang_Cursor_getLiteralString(
-                self
-            )
-        return self._literal
+        return conf.sealang.clang_Cursor_getLiteralString(self)
+
+    def _get_for_child(self, cursor):
+        # Hand out the matching child cursor so that the result compares and
+        # hashes like the one seen by get_children(). The native cursor lacks
+        # the parent declaration, so match on the statement pointer alone.
+        for child in self.get_children():
+            if child.data[1] == cursor.data[1]:
+                return child
+        cursor._tu = self._tu
+        return cursor
 
     @property
     def for_init(self):
         """
         Retrieves the for loop initializer at this cursor
         """
-        if not hasattr(self, "_for_init"):
-            self._for_init = conf.sealang.clang_getForStmtInit(
-                self
-            )
-            self._for_init._tu = self._tu
-
-            for child in self.get_children():
-                if self._for_init.extent == child.extent:
-                    self._for_init = child
-                    break
-        return self._for_init
+        return self._get_for_child(conf.sealang.clang_getForStmtInit(self))
 
     @property
     def for_cond(self):
         """
         Retrieves the for loop condition at this cursor
         """
-        if not hasattr(self, "_for_cond"):
-            self._for_cond = conf.sealang.clang_getForStmtCond(
-                self
-            )
-            self._for_cond._tu = self._tu
-
-            for child in self.get_children():
-                if self._for_cond.extent == child.extent:
-                    self._for_cond = child
-                    break
-        return self._for_cond
+        return self._get_for_child(conf.sealang.clang_getForStmtCond(self))
 
     @property
     def for_inc(self):
         """
         Retrieves the for loop increment at this cursor
         """
-        if not hasattr(self, "_for_inc"):
-            self._for_inc = conf.sealang.clang_getForStmtInc(
-                self
-            )
-            self._for_inc._tu = self._tu
-
-            for child in self.get_children():
-                if self._for_inc.extent == child.extent:
-                    self._for_inc = child
-                    break
-        return self._for_inc
+        return self._get_for_child(conf.sealang.clang_getForStmtInc(self))
 
     @property
     def for_body(self):
         """
         Retrieves the for loop body at this cursor
         """
-        if not hasattr(self, "_for_body"):
-            self._for_body = conf.sealang.clang_getForStmtBody(
-                self
-            )
-            self._for_body._tu = self._tu
-
-            for child in self.get_children():
-                if self._for_body.extent == child.extent:
-                    self._for_body = child
-                    break
-        return self._for_body
+        return self._get_for_child(conf.sealang.clang_getForStmtBody(self))
 
     @property
     def operator(self):
         """Retrieve the spelling of this TypeKind."""
-        if not hasattr(self, "_operator"):
-            self._operator = conf.sealang.clang_Cursor_getOperatorString(
-                self
-            )
-        return self._operator
+        return conf.sealang.clang_Cursor_getOperatorString(self)
 
     @property
     def unary_operator(self):
         """
         Retrieves the opcode if this cursor points to a binary operator
         """
-        if not hasattr(self, "_unaryopcode"):
-            self._unaryopcode = conf.sealang.clang_Cursor_getUnaryOpcode(self)
-        return UnaryOperator.from_id(self._unaryopcode)
+        return UnaryOperator.from_id(conf.sealang.clang_Cursor_getUnaryOpcode(self))
 
     @property
     def binary_operator(self):
         """
         Retrieves the opcode if this cursor points to a binary operator
         """
-        if not hasattr(self, "_binopcode"):
-            self._binopcode = conf.sealang.clang_Cursor_getBinaryOpcode(self)
-        return BinaryOperator.from_id(self._binopcode)
+        return BinaryOperator.from_id(conf.sealang.clang_Cursor_getBinaryOpcode(self))
 
     @property
     def access_specifier(self):
@@ -1697,10 +1643,7 @@ class Cursor(Structure):
         Retrieves the access specifier (if any) of the entity pointed at by the
         cursor.
         """
-        if not hasattr(self, "_access_specifier"):
-            self._access_specifier = conf.lib.clang_getCXXAccessSpecifier(self)
-
-        return AccessSpecifier.from_id(self._access_specifier)
+        return AccessSpecifier.from_id(conf.lib.clang_getCXXAccessSpecifier(self))
 
     @property
     def type(self):
@@ -1721,18 +1664,12 @@ class Cursor(Structure):
         declarations for the same class, the canonical cursor for the forward
         declarations will be identical.
         """
-        if not hasattr(self, "_canonical"):
-            self._canonical = conf.lib.clang_getCanonicalCursor(self)
-
-        return self._canonical
+        return conf.lib.clang_getCanonicalCursor(self)
 
     @property
     def result_type(self):
         """Retrieve the Type of the result for this Cursor."""
-        if not hasattr(self, "_result_type"):
-            self._result_type = conf.lib.clang_getResultType(self.type)
-
-        return self._result_type
+        return conf.lib.clang_getResultType(self.type)
 
     @property
     def exception_specification_kind(self):
@@ -1740,13 +1677,8 @@ class Cursor(Structure):
         Retrieve the exception specification kind, which is one of the values
         from the ExceptionSpecificationKind enumeration.
         """
-        if not hasattr(self, "_exception_specification_kind"):
-            exc_kind = conf.lib.clang_getCursorExceptionSpecificationType(self)
-            self._exception_specification_kind = ExceptionSpecificationKind.from_id(
-                exc_kind
-            )
-
-        return self._exception_specification_kind
+        exc_kind = conf.lib.clang_getCursorExceptionSpecificationType(self)
+        return ExceptionSpecificationKind.from_id(exc_kind)
 
     @property
     def underlying_typedef_type(self):
@@ -1755,13 +1687,8 @@ class Cursor(Structure):
         Returns a Type for the typedef this cursor is a declaration for. If
         the current cursor is not a typedef, this raises.
         """
-        if not hasattr(self, "_underlying_type"):
-            assert self.kind.is_declaration()
-            self._underlying_type = conf.lib.clang_getTypedefDeclUnderlyingType(
-                self
-            )
-
-        return self._underlying_type
+        assert self.kind.is_declaration()
+        return conf.lib.clang_getTypedefDeclUnderlyingType(self)
 
     @property
     def enum_type(self):
@@ -1770,51 +1697,37 @@ class Cursor(Structure):
         Returns a Type corresponding to an integer. If the cursor is not for an
         enum, this raises.
         """
-        if not hasattr(self, "_enum_type"):
-            assert self.kind == CursorKind.ENUM_DECL
-            self._enum_type = conf.lib.clang_getEnumDeclIntegerType(self)
-
-        return self._enum_type
+        assert self.kind == CursorKind.ENUM_DECL
+        return conf.lib.clang_getEnumDeclIntegerType(self)
 
     @property
     def enum_value(self):
         """Return the value of an enum constant."""
-        if not hasattr(self, "_enum_value"):
-            assert self.kind == CursorKind.ENUM_CONSTANT_DECL
-            # Figure out the underlying type of the enum to know if it
-            # is a signed or unsigned quantity.
-            underlying_type = self.type
-            if underlying_type.kind == TypeKind.ENUM:
-                underlying_type = underlying_type.get_declaration().enum_type
-            if underlying_type.kind in (
-                TypeKind.CHAR_U,
-                TypeKind.UCHAR,
-                TypeKind.CHAR16,
-                TypeKind.CHAR32,
-                TypeKind.USHORT,
-                TypeKind.UINT,
-                TypeKind.ULONG,
-                TypeKind.ULONGLONG,
-                TypeKind.UINT128,
-            ):
-                self._enum_value = conf.lib.clang_getEnumConstantDeclUnsignedValue(
-                    self
-                )
-            else:
-                self._enum_value = conf.lib.clang_getEnumConstantDeclValue(
-                    self
-                )
-        return self._enum_value
+        assert self.kind == CursorKind.ENUM_CONSTANT_DECL
+        # Figure out the underlying type of the enum to know if it
+        # is a signed or unsigned quantity.
+        underlying_type = self.type
+        if underlying_type.kind == TypeKind.ENUM:
+            underlying_type = underlying_type.get_declaration().enum_type
+        if underlying_type.kind in (
+            TypeKind.CHAR_U,
+            TypeKind.UCHAR,
+            TypeKind.CHAR16,
+            TypeKind.CHAR32,
+            TypeKind.USHORT,
+            TypeKind.UINT,
+            TypeKind.ULONG,
+            TypeKind.ULONGLONG,
+            TypeKind.UINT128,
+        ):
+            return conf.lib.clang_getEnumConstantDeclUnsignedValue(self)
+        else:
+            return conf.lib.clang_getEnumConstantDeclValue(self)
 
     @property
     def objc_type_encoding(self):
         """Return the Objective-C type encoding as a str."""
-        if not hasattr(self, "_objc_type_encoding"):
-            self._objc_type_encoding = conf.lib.clang_getDeclObjCTypeEncoding(
-                self
-            )
-
-        return self._objc_type_encoding
+        return conf.lib.clang_getDeclObjCTypeEncoding(self)
 
     @property
     def hash(self):
@@ -1827,20 +1740,93 @@ class Cursor(Structure):
     @property
     def semantic_parent(self):
         """Return the semantic parent for this cursor."""
-        if not hasattr(self, "_semantic_parent"):
-            self._semantic_parent = conf.lib.clang_getCursorSemanticParent(
-                self
-            )
-
-        return self._semantic_parent
+        return conf.lib.clang_getCursorSemanticParent(self)
 
     @property
     def lexical_parent(self):
         """Return the lexical parent for this cursor."""
-        if not hasattr(self, "_lexical_parent"):
-            self._lexical_parent = conf.lib.clang_getCursorLexicalParent(self)
+        return conf.lib.clang_getCursorLexicalParent(self)
+
+    @property
+    def parent(self):
+        """
+        Return the parent of this cursor as seen by get_children(). Unlike
+        semantic_parent and lexical_parent this works for statements and
+        expressions; declarations fall back to their lexical parent.
+        """
+        if not hasattr(self, "_parent"):
+            self._parent = conf.sealang.clang_ParentMap_getParent(
+                self._tu.parent_map, self
+            )
+            if self._parent is None and self.kind.is_declaration():
+                self._parent = self.lexical_parent
+
+        return self._parent
+
+    def get_ancestors(self):
+        """Iterate over the parents of this cursor, innermost first."""
+        cursor = self.parent
+        while cursor is not None:
+            yield cursor
+            cursor = cursor.parent
+
+    def enclosing(self, kind):
+        """Return the closest ancestor of the given CursorKind, or None."""
+        cursor = conf.sealang.clang_ParentMap_getEnclosing(
+            self._tu.parent_map, self, kind
+        )
+        if cursor is None:
+            # Above statements and local declarations only lexical parents
+            # are left.
+            cursor = next(
+                (c for c in self.get_ancestors() if c.kind == kind), None
+            )
+
+        return cursor
+
+    @staticmethod
+    def _print_source_options(qualified, compact, terse):
+        return (
+            (PrintSource.FULLY_QUALIFIED if qualified else 0)
+            | (PrintSource.COMPACT if compact else 0)
+            | (PrintSource.TERSE if terse else 0)
+        )
+
+    def print_source(self, qualified=False, compact=False, terse=False):
+        """
+        Return the source of this statement, expression or declaration as
+        printed by clang from the AST, or "" for other cursors. qualified
+        prints fully qualified names and canonical types, compact collapses
+        the output to one line and terse omits declaration bodies.
+        """
+        return conf.sealang.clang_Cursor_printSource(
+            self, Cursor._print_source_options(qualified, compact, terse)
+        )
+
+    @staticmethod
+    def print_sources(cursors, qualified=False, compact=False, terse=False):
+        """Return the print_source text of every cursor, with a single
+        native call."""
+        cursors = list(cursors)
+        array = (Cursor * len(cursors))(*cursors)
+        buffer = conf.sealang.clang_printCursors(
+            array,
+            len(cursors),
+            Cursor._print_source_options(qualified, compact, terse),
+        )
+        return buffer.get_strings(len(cursors))
 
-        return self._lexical_parent
+    def get_structural_hash(self, identifiers=False, literals=False):
+        """
+        Return the structural hash of this statement or expression subtree,
+        or of the body of this function, method or block; 0 otherwise.
+        Identifiers and literal values are only hashed when asked for, so by
+        default renamed copies of the same code hash alike.
+        """
+        options = (StructuralHash.IDENTIFIERS if identifiers else 0) | (
+            StructuralHash.LITERALS if literals else 0
+        )
+        return conf.sealang.clang_Cursor_getStructuralHash(self, options, None)
 
     @property
     def translation_unit(self):
@@ -1855,10 +1841,7 @@ class Cursor(Structure):
         For a cursor that is a reference, returns a cursor
         representing the entity that it references.
         """
-        if not hasattr(self, "_referenced"):
-            self._referenced = conf.lib.clang_getCursorReferenced(self)
-
-        return self._referenced
+        return conf.lib.clang_getCursorReferenced(self)
 
     @property
     def brief_comment(self):
@@ -2562,6 +2545,31 @@ class _CXUnsavedFile(Structure):
         ("length", c_ulong),
     ]
 
+    @staticmethod
+    def read(unsaved_files):
+        """Return unsaved_files as a list of (name, str) pairs, reading the
+        contents given as file objects."""
+        return [
+            (name, contents.read() if hasattr(contents, "read") else contents)
+            for name, contents in unsaved_files or []
+        ]
+
+    @staticmethod
+    def make_array(unsaved_files):
+        """Return a _CXUnsavedFile array of (name, contents) pairs, or None if
+        there are none. Contents are encoded as UTF-8; length is in bytes."""
+        unsaved_files = _CXUnsavedFile.read(unsaved_files)
+        if not unsaved_files:
+            return None
+
+        unsaved_array = (_CXUnsavedFile * len(unsaved_files))()
+        for i, (name, contents) in enumerate(unsaved_files):
+            contents = contents.encode("utf-8")
+            unsaved_array[i].name = str(name).encode("utf-8")
+            unsaved_array[i].contents = contents
+            unsaved_array[i].length = len(contents)
+        return unsaved_array
+
 
 # Functions calls through the python interface are rather slow. Fortunately,
 # for most symboles, we do not need to perform a function call. Their spelling
@@ -2945,16 +2953,7 @@ class TranslationUnit(ClangObject):
             bargs = [arg.encode("utf-8") for arg in args]
             args_array = (c_char_p * len(args))(*bargs)
 
-        unsaved_array = None
-        if len(unsaved_files) > 0:
-            unsaved_array = (_CXUnsavedFile * len(unsaved_files))()
-            for i, (name, contents) in enumerate(unsaved_files):
-                if hasattr(contents, "read"):
-                    contents = contents.read()
-
-                unsaved_array[i].name = name.encode("utf-8")
-                unsaved_array[i].contents = contents.encode("utf-8")
-                unsaved_array[i].length = len(contents)
+        unsaved_array = _CXUnsavedFile.make_array(unsaved_files)
 
         ptr = conf.lib.clang_parseTranslationUnit(
             index, filename,
@@ -3015,6 +3014,12 @@ class TranslationUnit(ClangObject):
         """Get the original translation unit source file name."""
         return conf.lib.clang_getTranslationUnitSpelling(self)
 
+    @CachedProperty
+    def parent_map(self):
+        """The ParentMap answering Cursor.parent queries for this translation
+        unit. Statement parents are built lazily, once per function."""
+        return ParentMap()
+
     def get_includes(self):
         """
         Return an iterable sequence of FileInclusion objects that describe the
@@ -3039,6 +3044,73 @@ class TranslationUnit(ClangObject):
 
         return iter(includes)
 
+    def get_include_graph(self):
+        """
+        Return the IncludeGraph of this translation unit. Unlike get_includes,
+        the whole graph is collected natively and exposed as compact arrays.
+        Per-file times and token counts are only available from
+        IncludeGraph.profile. Parse with PARSE_DETAILED_PROCESSING_RECORD to
+        get the same edges as IncludeGraph.profile, including directives
+        skipped by an include guard or #pragma once.
+        """
+        return conf.sealang.clang_TranslationUnit_getIncludeGraph(self)
+
+    def get_subtree_hashes(
+        self, min_size=10, identifiers=False, literals=False, main_file_only=True
+    ):
+        """
+        Return the SubtreeHashes of every statement subtree of at least
+        min_size nodes in the function, method and block bodies of this
+        translation unit, computed in a single native pass. See
+        Cursor.get_structural_hash for identifiers and literals.
+        """
+        options = (
+            (StructuralHash.IDENTIFIERS if identifiers else 0)
+            | (StructuralHash.LITERALS if literals else 0)
+            | (StructuralHash.MAIN_FILE_ONLY if main_file_only else 0)
+        )
+        hashes = conf.sealang.clang_TranslationUnit_getSubtreeHashes(
+            self, options, min_size
+        )
+        if hashes is not None:
+            hashes._tu = self
+        return hashes
+
+    def get_loop_nest(self, main_file_only=True):
+        """
+        Return the LoopNest of every loop in the function, method and block
+        bodies of this translation unit, collected in one native pass.
+        """
+        nest = conf.sealang.clang_TranslationUnit_getLoopNest(
+            self, LoopNest.MAIN_FILE_ONLY if main_file_only else 0
+        )
+        if nest is not None:
+            nest._tu = self
+        return nest
+
+    def get_openmp_directives(self, main_file_only=True):
+        """
+        Return the OpenMPDirectives of every executable OpenMP directive in
+        the function, method and block bodies of this translation unit, with
+        their clauses, collected in one native pass. The translation unit
+        must be parsed with -fopenmp.
+        """
+        directives = conf.sealang.clang_TranslationUnit_getOMPDirectives(
+            self, OpenMPDirectives.MAIN_FILE_ONLY if main_file_only else 0
+        )
+        if directives is not None:
+            directives._tu = self
+        return directives
+
+    def get_macro_index(self):
+        """
+        Return the MacroIndex of this translation unit, covering macro
+        definitions and expansions of every file. The translation unit must
+        be parsed with PARSE_DETAILED_PROCESSING_RECORD, otherwise None is
+        returned.
+        """
+        return conf.sealang.clang_TranslationUnit_getMacroIndex(self)
+
     def get_file(self, filename):
         """Obtain a File from this translation unit."""
 
@@ -3178,6 +3250,19 @@ class TranslationUnit(ClangObject):
                 result, "Error saving TranslationUnit."
             )
 
+    def get_resource_usage(self):
+        """Return the ResourceUsage of this translation unit."""
+        usage = conf.lib.clang_getCXTUResourceUsage(self)
+        try:
+            return ResourceUsage(
+                {
+                    usage.entries[i].kind: usage.entries[i].amount
+                    for i in range(usage.numEntries)
+                }
+            )
+        finally:
+            conf.lib.clang_disposeCXTUResourceUsage(usage)
+
     def codeComplete(
         self,
         path,
@@ -3234,6 +3319,34 @@ class TranslationUnit(ClangObject):
 
         return None
 
+    def complete(
+        self,
+        path,
+        line,
+        column,
+        prefix="",
+        limit=50,
+        unsaved_files=None,
+        include_macros=False,
+        include_code_patterns=False,
+    ):
+        """
+        Code complete in this translation unit, returning only the best limit
+        results whose typed text fuzzy-matches prefix, as TopCompletions.
+        Filtering, ranking and rendering happen natively, so the cost in
+        Python does not depend on the number of candidates.
+        """
+        options = (1 if include_macros else 0) | (2 if include_code_patterns else 0)
+
+        unsaved_files = list(unsaved_files or [])
+        unsaved_array = _CXUnsavedFile.make_array(unsaved_files)
+
+        return conf.sealang.clang_codeCompleteTopK(
+            self, path, line, column,
+            unsaved_array, len(unsaved_files),
+            options, prefix, limit,
+        )
+
     def get_tokens(self, locations=None, extent=None):
         """Obtain tokens in this translation unit.
 
@@ -3316,146 +3429,1679 @@ class FileInclusion:
         return self.depth == 0
 
 
-class CompilationDatabaseError(Exception):
-    """Represents an error that occurred when working with a CompilationDatabase
-
-    Each error is associated to an enumerated value, accessible under
-    e.cdb_error. Consumers can compare the value with one of the ERROR_
-    constants in this class.
+class IncludeEdge(Structure):
+    """
+    A single #include directive of an IncludeGraph. includer and included are
+    indexes into IncludeGraph.files, line/column/offset locate the included
+    file name inside the includer.
     """
 
-    # An unknown error occurred
-    ERROR_UNKNOWN = 0
-
-    # The database could not be loaded
-    ERROR_CANNOTLOADDATABASE = 1
-
-    def __init__(self, enumeration, message):
-        assert isinstance(enumeration, int)
+    _fields_ = [
+        ("includer", c_uint),
+        ("included", c_uint),
+        ("line", c_uint),
+        ("column", c_uint),
+        ("offset", c_uint),
+    ]
 
-        if enumeration > 1:
-            raise Exception(
-                "Encountered undefined CompilationDatabase error "
-                f"constant: {enumeration:d}. Please file a bug to have this "
-                "value supported."
-            )
+    def __repr__(self):
+        return (
+            f"<IncludeEdge {self.includer} -> {self.included}, "
+            f"line {self.line}, column {self.column}>"
+        )
 
-        self.cdb_error = enumeration
-        Exception.__init__(self, f"Error {enumeration:d}: {message}")
 
+class IncludeFileStats(Structure):
+    """
+    Per-file annotations of an IncludeGraph. depth is the shallowest include
+    depth of the file (the input file has depth 0) and num_entries the number
+    of times the preprocessor entered it. Times are wall-clock seconds:
+    self_time excludes nested includes, total_time includes them.
+    """
 
-class CompileCommand:
-    """Represents the compile command used to build a file"""
+    _fields_ = [
+        ("depth", c_uint),
+        ("num_entries", c_uint),
+        ("num_tokens", c_ulonglong),
+        ("size", c_ulonglong),
+        ("self_time", c_double),
+        ("total_time", c_double),
+    ]
 
-    def __init__(self, cmd, ccmds):
-        self.cmd = cmd
-        # Keep a reference to the originating CompileCommands
-        # to prevent garbage collection
-        self.ccmds = ccmds
 
-    @property
-    def directory(self):
-        """Get the working directory for this CompileCommand"""
-        return conf.lib.clang_CompileCommand_getDirectory(self.cmd)
+class IncludeGraph(ClangObject):
+    """
+    The include DAG of a translation unit. Files are identified by their index
+    in files; stats and edges are ctypes arrays of IncludeFileStats and
+    IncludeEdge.
+    """
 
-    @property
-    def filename(self):
-        """Get the working filename for this CompileCommand"""
-        return conf.lib.clang_CompileCommand_getFilename(self.cmd)
+    @staticmethod
+    def profile(filename, args=None, unsaved_files=None):
+        """Parse filename (syntax only) and return its IncludeGraph annotated
+        with the time and expanded tokens spent in every file.
 
-    @property
-    def arguments(self):
+        args and unsaved_files have the same meaning as in
+        TranslationUnit.from_source. The file is parsed from scratch and no
+        TranslationUnit is kept, so this is cheap enough to run over a whole
+        compilation database.
         """
-        Get an iterable object providing each argument in the
-        command line for the compiler invocation as a _CXString.
+        if args is None:
+            args = []
 
-        Invariant : the first argument is the compiler executable
-        """
-        length = conf.lib.clang_CompileCommand_getNumArgs(self.cmd)
-        for i in range(length):
-            yield conf.lib.clang_CompileCommand_getArg(self.cmd, i)
+        if unsaved_files is None:
+            unsaved_files = []
+
+        args_array = None
+        if len(args) > 0:
+            bargs = [arg.encode("utf-8") for arg in args]
+            args_array = (c_char_p * len(args))(*bargs)
 
+        unsaved_array = _CXUnsavedFile.make_array(unsaved_files)
 
-class CompileCommands:
-    """
-    CompileCommands is an iterable object containing all CompileCommand
-    that can be used for building a specific file.
-    """
+        graph = conf.sealang.clang_profileIncludeGraph(
+            filename,
+            args_array, len(args),
+            unsaved_array, len(unsaved_files),
+        )
+        if graph is None:
+            raise TranslationUnitLoadError("Error profiling translation unit.")
 
-    def __init__(self, ccmds):
-        self.ccmds = ccmds
+        return graph
 
     def __del__(self):
-        conf.lib.clang_CompileCommands_dispose(self.ccmds)
+        conf.sealang.clang_IncludeGraph_dispose(self)
 
     def __len__(self):
-        return int(conf.lib.clang_CompileCommands_getSize(self.ccmds))
+        return int(conf.sealang.clang_IncludeGraph_getNumFiles(self))
 
-    def __getitem__(self, i):
-        cc = conf.lib.clang_CompileCommands_getCommand(self.ccmds, i)
-        if not cc:
-            raise IndexError
-        return CompileCommand(cc, self)
+    @CachedProperty
+    def files(self):
+        """The file names, indexed by file id."""
+        return [
+            conf.sealang.clang_IncludeGraph_getFileName(self, i)
+            for i in range(len(self))
+        ]
+
+    @CachedProperty
+    def stats(self):
+        """An IncludeFileStats array, indexed by file id."""
+        stats = (IncludeFileStats * len(self))()
+        if len(stats):
+            memmove(
+                stats,
+                conf.sealang.clang_IncludeGraph_getFileStats(self),
+                sizeof(stats),
+            )
+        return stats
+
+    @CachedProperty
+    def edges(self):
+        """An IncludeEdge array, in the order the directives were seen."""
+        count = conf.sealang.clang_IncludeGraph_getNumEdges(self)
+        edges = (IncludeEdge * count)()
+        if count:
+            memmove(
+                edges,
+                conf.sealang.clang_IncludeGraph_getEdges(self),
+                sizeof(edges),
+            )
+        return edges
 
     @staticmethod
     def from_result(res, fn, args):
         if not res:
             return None
-        return CompileCommands(res)
+        return IncludeGraph(res)
 
 
-class CompilationDatabase(ClangObject):
+class IncludeCostEntry(Structure):
+    """
+    Include costs of a single file, summed over every translation unit added
+    to an IncludeCostTable.
     """
-    The CompilationDatabase is a wrapper class around
-    clang::tooling::CompilationDatabase
 
-    It enables querying how a specific source file can be built.
+    _fields_ = [
+        ("num_translation_units", c_uint),
+        ("num_includes", c_uint),
+        ("min_depth", c_uint),
+        ("num_tokens", c_ulonglong),
+        ("size", c_ulonglong),
+        ("self_time", c_double),
+        ("total_time", c_double),
+    ]
+
+
+class IncludeCostTable(ClangObject):
     """
+    Aggregates IncludeGraph annotations over many translation units, so that
+    headers can be ranked by their total cost across a project.
+    """
+
+    def __init__(self):
+        ClangObject.__init__(self, conf.sealang.clang_IncludeCostTable_create())
 
     def __del__(self):
-        conf.lib.clang_CompilationDatabase_dispose(self)
+        conf.sealang.clang_IncludeCostTable_dispose(self)
 
-    @staticmethod
-    def from_result(res, fn, args):
-        if not res:
-            raise CompilationDatabaseError(
-                0, "CompilationDatabase loading failed"
-            )
-        return CompilationDatabase(res)
+    def __len__(self):
+        return int(conf.sealang.clang_IncludeCostTable_getNumFiles(self))
+
+    def add(self, graph):
+        """Merge an IncludeGraph into the table."""
+        conf.sealang.clang_IncludeCostTable_add(self, graph)
+
+    def add_compile_command(self, cmd):
+        """Profile a CompileCommand and merge its IncludeGraph. The compiler
+        executable is dropped from the arguments and the command's directory
+        is used as working directory."""
+        args = list(cmd.arguments)[1:]
+        args.insert(0, "-working-directory=" + cmd.directory)
+        graph = IncludeGraph.profile(None, args)
+        self.add(graph)
+        return graph
+
+    def add_compilation_database(self, cdb):
+        """Profile and merge every command of a CompilationDatabase. Commands
+        that cannot be turned into a compiler invocation are skipped. Returns
+        the number of translation units added."""
+        count = 0
+        for cmd in cdb.getAllCompileCommands() or []:
+            try:
+                self.add_compile_command(cmd)
+            except TranslationUnitLoadError:
+                continue
+            count += 1
+        return count
 
-    @staticmethod
-    def fromDirectory(buildDir):
-        """Builds a CompilationDatabase from the database found in buildDir"""
-        errorCode = c_uint()
-        try:
-            cdb = conf.lib.clang_CompilationDatabase_fromDirectory(
-                buildDir, byref(errorCode)
-            )
-        except CompilationDatabaseError:
-            raise CompilationDatabaseError(
-                int(errorCode.value), "CompilationDatabase loading failed"
-            )
-        return cdb
+    @property
+    def files(self):
+        """The file names, indexed by file id."""
+        return [
+            conf.sealang.clang_IncludeCostTable_getFileName(self, i)
+            for i in range(len(self))
+        ]
 
-    def getCompileCommands(self, filename):
-        """
-        Get an iterable object providing all the CompileCommands available to
-        build filename. Returns None if filename is not found in the database.
-        """
-        return conf.lib.clang_CompilationDatabase_getCompileCommands(
-            self, filename
+    @property
+    def entries(self):
+        """An IncludeCostEntry array, indexed by file id."""
+        entries = (IncludeCostEntry * len(self))()
+        if len(entries):
+            memmove(
+                entries,
+                conf.sealang.clang_IncludeCostTable_getEntries(self),
+                sizeof(entries),
+            )
+        return entries
+
+    def ranking(self, key="total_time", limit=None):
+        """Return (file name, IncludeCostEntry) pairs, most expensive first.
+        key is the name of the IncludeCostEntry field to rank by."""
+        ranked = sorted(
+            zip(self.files, self.entries),
+            key=lambda item: getattr(item[1], key),
+            reverse=True,
         )
+        return ranked[:limit] if limit is not None else ranked
 
-    def getAllCompileCommands(self):
-        """
-        Get an iterable object providing all the CompileCommands available from
-        the database.
-        """
-        return conf.lib.clang_CompilationDatabase_getAllCompileCommands(self)
 
+class MacroDefinitionInfo(Structure):
+    """
+    A macro definition of a MacroIndex. file indexes MacroIndex.files and is
+    ~0 for builtin macros. num_params is -1 for object-like macros and does
+    not count an unnamed "..." parameter, see is_variadic. The
+    expansions of the definition are MacroIndex.expansions[first_expansion:
+    first_expansion + num_expansions].
+    """
 
-class Token(Structure):
-    """Represents a single token from the preprocessor.
+    _fields_ = [
+        ("file", c_uint),
+        ("line", c_uint),
+        ("column", c_uint),
+        ("offset", c_uint),
+        ("num_params", c_int),
+        ("is_variadic", c_uint),
+        ("first_expansion", c_uint),
+        ("num_expansions", c_uint),
+    ]
+
+
+class MacroExpansionInfo(Structure):
+    """
+    A macro expansion of a MacroIndex. definition indexes
+    MacroIndex.definitions, or is -1 when the definition is not part of the
+    index (e.g. it comes from a preamble); such expansions are last.
+    num_args is -1 for object-like macros and produced_ast tells whether any
+    declaration, statement or type comes from the expansion.
+    """
+
+    _fields_ = [
+        ("definition", c_int),
+        ("file", c_uint),
+        ("line", c_uint),
+        ("column", c_uint),
+        ("offset", c_uint),
+        ("num_args", c_int),
+        ("produced_ast", c_uint),
+    ]
+
+    def __repr__(self):
+        return (
+            f"<MacroExpansionInfo definition {self.definition}, file "
+            f"{self.file}, line {self.line}, column {self.column}>"
+        )
+
+
+class MacroIndex(ClangObject):
+    """
+    Native index of the macro definitions and expansions of a translation
+    unit. Definitions are sorted by name, expansions are grouped by
+    definition.
+    """
+
+    def __del__(self):
+        conf.sealang.clang_MacroIndex_dispose(self)
+
+    @CachedProperty
+    def files(self):
+        """The file names, indexed by file id."""
+        return [
+            conf.sealang.clang_MacroIndex_getFileName(self, i)
+            for i in range(conf.sealang.clang_MacroIndex_getNumFiles(self))
+        ]
+
+    @CachedProperty
+    def names(self):
+        """The macro names, indexed by definition."""
+        return [
+            conf.sealang.clang_MacroIndex_getDefinitionName(self, i)
+            for i in range(len(self.definitions))
+        ]
+
+    @CachedProperty
+    def definitions(self):
+        """A MacroDefinitionInfo array."""
+        count = conf.sealang.clang_MacroIndex_getNumDefinitions(self)
+        definitions = (MacroDefinitionInfo * count)()
+        if count:
+            memmove(
+                definitions,
+                conf.sealang.clang_MacroIndex_getDefinitions(self),
+                sizeof(definitions),
+            )
+        return definitions
+
+    @CachedProperty
+    def expansions(self):
+        """A MacroExpansionInfo array."""
+        count = conf.sealang.clang_MacroIndex_getNumExpansions(self)
+        expansions = (MacroExpansionInfo * count)()
+        if count:
+            memmove(
+                expansions,
+                conf.sealang.clang_MacroIndex_getExpansions(self),
+                sizeof(expansions),
+            )
+        return expansions
+
+    def find(self, name):
+        """Return the indexes of the definitions of the named macro."""
+        first = conf.sealang.clang_MacroIndex_findDefinition(self, name)
+        if first < 0:
+            return []
+
+        last = first + 1
+        while last < len(self.names) and self.names[last] == name:
+            last += 1
+        return list(range(first, last))
+
+    def get_expansions(self, name):
+        """Return the MacroExpansionInfos of every definition of the named
+        macro, in source order within each definition."""
+        expansions = []
+        for index in self.find(name):
+            definition = self.definitions[index]
+            first = definition.first_expansion
+            expansions.extend(
+                self.expansions[first:first + definition.num_expansions]
+            )
+        return expansions
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return MacroIndex(res)
+
+
+class ParentMap(ClangObject):
+    """
+    Native cache of statement parent maps. Each function body is indexed the
+    first time one of its statements is asked for its parent, after which
+    every parent lookup is a hash table access.
+    """
+
+    def __init__(self):
+        ClangObject.__init__(self, conf.sealang.clang_ParentMap_create())
+
+    def __del__(self):
+        conf.sealang.clang_ParentMap_dispose(self)
+
+
+class DispatchTable(ClangObject):
+    """
+    Native, kind-indexed routing of cursors to rules. Rules are identified by
+    an index in range(num_rules) and register interests in cursor kinds with
+    add_interest; collect then walks a cursor tree once and records every
+    cursor under each rule interested in it.
+    """
+
+    def __init__(self, num_rules):
+        ClangObject.__init__(
+            self, conf.sealang.clang_DispatchTable_create(num_rules)
+        )
+        self.num_rules = num_rules
+
+    def __del__(self):
+        conf.sealang.clang_DispatchTable_dispose(self)
+
+    def add_interest(self, rule, kind, opcode=None):
+        """Route cursors of the given CursorKind to rule. opcode optionally
+        restricts operator kinds to a single BinaryOperator/UnaryOperator."""
+        conf.sealang.clang_DispatchTable_addInterest(
+            self, rule, kind, -1 if opcode is None else int(opcode)
+        )
+
+    def collect(self, cursor):
+        """Walk cursor and its descendants once. Returns the total number of
+        matches; matches of a previous walk are discarded."""
+        self._tu = cursor.translation_unit
+        return int(conf.sealang.clang_DispatchTable_collect(self, cursor))
+
+    def collect_many(self, cursors):
+        """Walk each of cursors and their descendants, in order, as a single
+        collect."""
+        cursors = list(cursors)
+        if cursors:
+            self._tu = cursors[0].translation_unit
+        array = (Cursor * len(cursors))(*cursors)
+        return int(
+            conf.sealang.clang_DispatchTable_collectMany(self, array, len(cursors))
+        )
+
+    def get_matches(self, rule):
+        """Return the list of cursors collected for rule, in preorder."""
+        count = conf.sealang.clang_DispatchTable_getNumMatches(self, rule)
+        matches = (Cursor * count)()
+        if count:
+            memmove(
+                matches,
+                conf.sealang.clang_DispatchTable_getMatches(self, rule),
+                sizeof(matches),
+            )
+
+        # Cursors share the array's memory; keep each wrapper so the TU
+        # reference sticks.
+        cursors = list(matches)
+        for cursor in cursors:
+            cursor._tu = self._tu
+        return cursors
+
+
+class Rule:
+    """
+    Base class for rules run by a RuleEngine.
+
+    kinds lists the CursorKinds the rule wants to see. operators lists
+    BinaryOperator/UnaryOperator values; they add the matching operator
+    cursors without requiring the whole operator kind. Subclasses override
+    visit, or check to process all the matches of a translation unit at once.
+    """
+
+    kinds = ()
+    operators = ()
+
+    def visit(self, cursor):
+        """Called for every matching cursor. Non-None results are collected."""
+        return None
+
+    def check(self, cursors):
+        """Called once per walk with all the matching cursors, in preorder.
+        Returns the list of results of the rule."""
+        results = []
+        for cursor in cursors:
+            result = self.visit(cursor)
+            if result is not None:
+                results.append(result)
+        return results
+
+
+class RuleEngine:
+    """
+    Runs many Rules over a cursor tree with a single native traversal. The
+    cost of a run is one walk plus one call per rule and per matching cursor,
+    instead of one walk per rule.
+    """
+
+    def __init__(self, rules):
+        self.rules = list(rules)
+        self.table = DispatchTable(len(self.rules))
+
+        for index, rule in enumerate(self.rules):
+            for kind in rule.kinds:
+                self.table.add_interest(index, kind)
+
+            for op in rule.operators:
+                if isinstance(op, UnaryOperator):
+                    self.table.add_interest(
+                        index, CursorKind.UNARY_OPERATOR, op
+                    )
+                    continue
+
+                self.table.add_interest(index, CursorKind.BINARY_OPERATOR, op)
+                if op.is_assignment and op != BinaryOperator.ASSIGN:
+                    self.table.add_interest(
+                        index, CursorKind.COMPOUND_ASSIGNMENT_OPERATOR, op
+                    )
+
+    def run(self, source, dedup=None):
+        """Run every rule over source, a TranslationUnit or Cursor. Returns a
+        dict mapping each rule to the list of its results. With a HeaderDedup
+        session and a TranslationUnit, declarations of headers already seen
+        in the session are skipped."""
+        if dedup is not None and isinstance(source, TranslationUnit):
+            self.table.collect_many(dedup.get_children(source))
+        else:
+            cursor = source.cursor if isinstance(source, TranslationUnit) else source
+            self.table.collect(cursor)
+
+        return {
+            rule: rule.check(self.table.get_matches(index))
+            for index, rule in enumerate(self.rules)
+        }
+
+
+class RewriteRejection(Structure):
+    """
+    An edit of a RewriteBatch that was not applied. edit is the position of
+    the edit in submission order, reason one of RewriteBatch.OVERLAP and
+    RewriteBatch.INVALID_RANGE.
+    """
+
+    _fields_ = [("edit", c_uint), ("reason", c_uint)]
+
+    def __repr__(self):
+        return f"<RewriteRejection edit {self.edit}, reason {self.reason}>"
+
+
+class RewriteBatch(ClangObject):
+    """
+    A batch of source edits on a translation unit, applied natively with
+    clang's Rewriter in a single pass. Each edit replaces the characters of a
+    SourceRange (an empty range inserts); offsets are bytes, so multi-byte
+    UTF-8 text is preserved as is.
+    """
+
+    # Rejection reasons.
+    OVERLAP = 1
+    INVALID_RANGE = 2
+
+    def __init__(self, tu):
+        ClangObject.__init__(self, conf.sealang.clang_RewriteBatch_create(tu))
+        self._tu = tu
+        self.rejections = []
+
+    def __del__(self):
+        conf.sealang.clang_RewriteBatch_dispose(self)
+
+    def add_edits(self, edits):
+        """Queue an iterable of (extent, text) edits. extent is a SourceRange
+        or a Cursor, whose extent is used."""
+        edits = list(edits)
+        ranges = (SourceRange * len(edits))()
+        texts = (c_char_p * len(edits))()
+        for i, (extent, text) in enumerate(edits):
+            ranges[i] = extent.extent if isinstance(extent, Cursor) else extent
+            texts[i] = text.encode("utf-8")
+
+        conf.sealang.clang_RewriteBatch_addEdits(self, ranges, texts, len(edits))
+
+    def replace(self, extent, text):
+        """Queue the replacement of extent with text."""
+        self.add_edits([(extent, text)])
+
+    def insert(self, location, text):
+        """Queue the insertion of text before location."""
+        self.add_edits([(SourceRange.from_locations(location, location), text)])
+
+    def remove(self, extent):
+        """Queue the removal of extent."""
+        self.add_edits([(extent, "")])
+
+    def add_fixits(self):
+        """Queue the fix-its of every warning and error of the translation
+        unit. Returns the number of edits queued."""
+        return int(conf.sealang.clang_RewriteBatch_addFixIts(self))
+
+    def apply(self, encoding="utf-8"):
+        """Apply the queued edits. Returns a dict mapping each modified file
+        name to its new contents, decoded with encoding, or bytes if encoding
+        is None. Edits overlapping an earlier edit, or spanning macro
+        expansions or several files, are skipped and listed in
+        self.rejections. A header included several times gets a single
+        buffer holding the edits made through any of its inclusions."""
+        count = conf.sealang.clang_RewriteBatch_apply(self)
+        rejections = (RewriteRejection * count)()
+        if count:
+            memmove(
+                rejections,
+                conf.sealang.clang_RewriteBatch_getRejections(self),
+                sizeof(rejections),
+            )
+        self.rejections = list(rejections)
+
+        buffers = {}
+        length = c_uint()
+        for i in range(conf.sealang.clang_RewriteBatch_getNumFiles(self)):
+            data = conf.sealang.clang_RewriteBatch_getBuffer(self, i, byref(length))
+            contents = string_at(data, length.value)
+            if encoding is not None:
+                contents = contents.decode(encoding)
+            buffers[conf.sealang.clang_RewriteBatch_getFileName(self, i)] = contents
+        return buffers
+
+
+class PrintSource:
+    """Option flags of Cursor.print_source."""
+
+    FULLY_QUALIFIED = 0x1
+    COMPACT = 0x2
+    TERSE = 0x4
+
+
+class PrintBuffer(ClangObject):
+    """
+    The concatenated output of Cursor.print_sources, with the offset of the
+    text of every cursor.
+    """
+
+    def __del__(self):
+        conf.sealang.clang_PrintBuffer_dispose(self)
+
+    def get_strings(self, count):
+        """Return the texts of the first count cursors."""
+        length = c_uint()
+        data = string_at(
+            conf.sealang.clang_PrintBuffer_getData(self, byref(length)),
+            length.value,
+        )
+        offsets = conf.sealang.clang_PrintBuffer_getOffsets(self)
+        return [
+            data[offsets[i]:offsets[i + 1]].decode("utf-8") for i in range(count)
+        ]
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return PrintBuffer(res)
+
+
+class StructuralHash:
+    """Option flags of structural hashing."""
+
+    IDENTIFIERS = 0x1
+    LITERALS = 0x2
+    MAIN_FILE_ONLY = 0x4
+
+
+class SubtreeHash(Structure):
+    """
+    The structural hash of a statement subtree: its size in nodes, CursorKind
+    id and position. file indexes the files of the SubtreeHashes or
+    CloneIndex the record comes from.
+    """
+
+    _fields_ = [
+        ("hash", c_ulonglong),
+        ("size", c_uint),
+        ("kind_id", c_uint),
+        ("file", c_uint),
+        ("line", c_uint),
+        ("column", c_uint),
+        ("offset", c_uint),
+    ]
+
+    @property
+    def kind(self):
+        return CursorKind.from_id(self.kind_id)
+
+    def __repr__(self):
+        return (
+            f"<SubtreeHash {self.hash:016x}, size {self.size}, file "
+            f"{self.file}, line {self.line}, column {self.column}>"
+        )
+
+
+class SubtreeHashes(ClangObject):
+    """
+    The subtree hashes of a translation unit, in preorder. Create with
+    TranslationUnit.get_subtree_hashes.
+    """
+
+    def __del__(self):
+        conf.sealang.clang_SubtreeHashes_dispose(self)
+
+    @CachedProperty
+    def files(self):
+        """The file names, indexed by file id."""
+        return [
+            conf.sealang.clang_SubtreeHashes_getFileName(self, i)
+            for i in range(conf.sealang.clang_SubtreeHashes_getNumFiles(self))
+        ]
+
+    @CachedProperty
+    def records(self):
+        """A SubtreeHash array."""
+        count = conf.sealang.clang_SubtreeHashes_getNumRecords(self)
+        records = (SubtreeHash * count)()
+        if count:
+            memmove(
+                records,
+                conf.sealang.clang_SubtreeHashes_getRecords(self),
+                sizeof(records),
+            )
+        return records
+
+    def get_cursor(self, index):
+        """Return the Cursor of records[index]."""
+        cursor = conf.sealang.clang_SubtreeHashes_getCursor(self, index)
+        if cursor is not None:
+            cursor._tu = self._tu
+        return cursor
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return SubtreeHashes(res)
+
+
+class CloneBucket(Structure):
+    """A range of CloneIndex records sharing a hash."""
+
+    _fields_ = [("hash", c_ulonglong), ("first", c_uint), ("count", c_uint)]
+
+
+class CloneIndex(ClangObject):
+    """
+    Subtree hashes merged across translation units. Adding a translation
+    unit is a linear copy of its records; get_buckets then joins them on the
+    hash natively. Records keep file and position only, so translation units
+    can be released once added.
+    """
+
+    def __init__(self):
+        ClangObject.__init__(self, conf.sealang.clang_CloneIndex_create())
+
+    def __del__(self):
+        conf.sealang.clang_CloneIndex_dispose(self)
+
+    def add(self, source, **kwargs):
+        """Merge source, a SubtreeHashes or a TranslationUnit whose hashes are
+        computed with the TranslationUnit.get_subtree_hashes kwargs."""
+        if isinstance(source, TranslationUnit):
+            source = source.get_subtree_hashes(**kwargs)
+        conf.sealang.clang_CloneIndex_add(self, source)
+
+    @property
+    def files(self):
+        """The file names, indexed by file id."""
+        return [
+            conf.sealang.clang_CloneIndex_getFileName(self, i)
+            for i in range(conf.sealang.clang_CloneIndex_getNumFiles(self))
+        ]
+
+    def get_buckets(self, min_count=2):
+        """Return the lists of SubtreeHash records sharing a hash, for hashes
+        with at least min_count distinct subtrees."""
+        count = conf.sealang.clang_CloneIndex_computeBuckets(self, min_count)
+        buckets = (CloneBucket * count)()
+        if count:
+            memmove(
+                buckets,
+                conf.sealang.clang_CloneIndex_getBuckets(self),
+                sizeof(buckets),
+            )
+
+        total = conf.sealang.clang_CloneIndex_getNumRecords(self)
+        records = (SubtreeHash * total)()
+        if total:
+            memmove(
+                records,
+                conf.sealang.clang_CloneIndex_getRecords(self),
+                sizeof(records),
+            )
+        return [
+            records[bucket.first:bucket.first + bucket.count] for bucket in buckets
+        ]
+
+
+class LoopInfo(Structure):
+    """
+    A loop of a LoopNest, as returned by the native API. flags combines the
+    LoopInfo constants; bounds and step are only meaningful when the
+    matching flag is set.
+    """
+
+    CANONICAL = 0x1
+    CONSTANT_LOWER_BOUND = 0x2
+    CONSTANT_UPPER_BOUND = 0x4
+    CONSTANT_STEP = 0x8
+
+    _fields_ = [
+        ("kind_id", c_uint),
+        ("parent", c_int),
+        ("depth", c_uint),
+        ("flags", c_uint),
+        ("comparison_id", c_int),
+        ("lower_bound", c_longlong),
+        ("upper_bound", c_longlong),
+        ("step", c_longlong),
+        ("first_array", c_uint),
+        ("num_arrays", c_uint),
+    ]
+
+
+class Loop:
+    """
+    A for, while, do or range-based for loop of a LoopNest. parent and
+    children are indexes into LoopNest.loops. For canonical for loops,
+    induction_variable is the VarDecl cursor of the induction variable,
+    comparison the BinaryOperator of the condition with the variable on the
+    left, and lower_bound/upper_bound/step their constant values, or None
+    when not constant.
+    """
+
+    def __init__(self, info, cursor, induction_variable, arrays):
+        self.cursor = cursor
+        self.kind = CursorKind.from_id(info.kind_id)
+        self.parent = info.parent if info.parent >= 0 else None
+        self.children = []
+        self.depth = info.depth
+        self.is_canonical = bool(info.flags & LoopInfo.CANONICAL)
+        self.induction_variable = induction_variable
+        self.comparison = (
+            BinaryOperator.from_id(info.comparison_id) if self.is_canonical else None
+        )
+
+        def constant(flag, value):
+            return value if info.flags & flag else None
+
+        self.lower_bound = constant(LoopInfo.CONSTANT_LOWER_BOUND, info.lower_bound)
+        self.upper_bound = constant(LoopInfo.CONSTANT_UPPER_BOUND, info.upper_bound)
+        self.step = constant(LoopInfo.CONSTANT_STEP, info.step)
+        self.arrays = arrays
+
+    def __repr__(self):
+        return f"<Loop {self.kind}, depth {self.depth}, line {self.cursor.location.line}>"
+
+
+class LoopNest(ClangObject):
+    """
+    The loop-nest forest of a translation unit. Create with
+    TranslationUnit.get_loop_nest.
+    """
+
+    # Options.
+    MAIN_FILE_ONLY = 0x1
+
+    def __del__(self):
+        conf.sealang.clang_LoopNest_dispose(self)
+
+    def _cursors(self, getter, count):
+        cursors = (Cursor * count)()
+        if count:
+            memmove(cursors, getter(self), sizeof(cursors))
+
+        result = []
+        for cursor in cursors:
+            if cursor.kind == CursorKind.INVALID_FILE:
+                result.append(None)
+                continue
+            cursor._tu = self._tu
+            result.append(cursor)
+        return result
+
+    @CachedProperty
+    def infos(self):
+        """A LoopInfo array."""
+        count = conf.sealang.clang_LoopNest_getNumLoops(self)
+        infos = (LoopInfo * count)()
+        if count:
+            memmove(infos, conf.sealang.clang_LoopNest_getLoops(self), sizeof(infos))
+        return infos
+
+    @CachedProperty
+    def loops(self):
+        """The list of Loops, in preorder."""
+        count = len(self.infos)
+        cursors = self._cursors(conf.sealang.clang_LoopNest_getCursors, count)
+        variables = self._cursors(
+            conf.sealang.clang_LoopNest_getInductionVariables, count
+        )
+        arrays = self._cursors(
+            conf.sealang.clang_LoopNest_getArrays,
+            conf.sealang.clang_LoopNest_getNumArrays(self),
+        )
+
+        loops = []
+        for info, cursor, variable in zip(self.infos, cursors, variables):
+            first = info.first_array
+            loop = Loop(info, cursor, variable, arrays[first:first + info.num_arrays])
+            if loop.parent is not None:
+                loops[loop.parent].children.append(len(loops))
+            loops.append(loop)
+        return loops
+
+    @property
+    def roots(self):
+        """The outermost Loops."""
+        return [loop for loop in self.loops if loop.parent is None]
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return LoopNest(res)
+
+
+class CXTUResourceUsageEntry(Structure):
+    _fields_ = [("kind", c_int), ("amount", c_ulong)]
+
+
+class CXTUResourceUsage(Structure):
+    _fields_ = [
+        ("data", c_void_p),
+        ("numEntries", c_uint),
+        ("entries", POINTER(CXTUResourceUsageEntry)),
+    ]
+
+
+class ResourceUsage:
+    """
+    Memory held by a TranslationUnit, in bytes. amounts maps each
+    CXTUResourceUsageKind to its bytes and entries each kind name; the
+    properties group them by component. Memory-mapped buffers are counted in
+    total but not in resident, since the system can page them out.
+    """
+
+    AST = 1
+    IDENTIFIERS = 2
+    SELECTORS = 3
+    GLOBAL_COMPLETION_RESULTS = 4
+    SOURCE_MANAGER_CONTENT_CACHE = 5
+    AST_SIDE_TABLES = 6
+    SOURCE_MANAGER_MEMBUFFER_MALLOC = 7
+    SOURCE_MANAGER_MEMBUFFER_MMAP = 8
+    EXTERNAL_AST_SOURCE_MEMBUFFER_MALLOC = 9
+    EXTERNAL_AST_SOURCE_MEMBUFFER_MMAP = 10
+    PREPROCESSOR = 11
+    PREPROCESSING_RECORD = 12
+    SOURCE_MANAGER_DATA_STRUCTURES = 13
+    PREPROCESSOR_HEADER_SEARCH = 14
+
+    MMAP = (SOURCE_MANAGER_MEMBUFFER_MMAP, EXTERNAL_AST_SOURCE_MEMBUFFER_MMAP)
+
+    def __init__(self, amounts):
+        self.amounts = amounts
+
+    def _sum(self, *kinds):
+        return sum(self.amounts.get(kind, 0) for kind in kinds)
+
+    @property
+    def entries(self):
+        return {
+            conf.lib.clang_getTUResourceUsageName(kind): amount
+            for kind, amount in self.amounts.items()
+        }
+
+    @property
+    def ast(self):
+        """AST nodes and side tables."""
+        return self._sum(self.AST, self.AST_SIDE_TABLES)
+
+    @property
+    def identifiers(self):
+        """Identifier and selector tables."""
+        return self._sum(self.IDENTIFIERS, self.SELECTORS)
+
+    @property
+    def source_manager(self):
+        """File contents and source manager tables."""
+        return self._sum(
+            self.SOURCE_MANAGER_CONTENT_CACHE,
+            self.SOURCE_MANAGER_MEMBUFFER_MALLOC,
+            self.SOURCE_MANAGER_MEMBUFFER_MMAP,
+            self.SOURCE_MANAGER_DATA_STRUCTURES,
+        )
+
+    @property
+    def preamble(self):
+        """Buffers of the external AST source, i.e. the precompiled
+        preamble."""
+        return self._sum(
+            self.EXTERNAL_AST_SOURCE_MEMBUFFER_MALLOC,
+            self.EXTERNAL_AST_SOURCE_MEMBUFFER_MMAP,
+        )
+
+    @property
+    def preprocessor(self):
+        return self._sum(
+            self.PREPROCESSOR,
+            self.PREPROCESSING_RECORD,
+            self.PREPROCESSOR_HEADER_SEARCH,
+        )
+
+    @property
+    def total(self):
+        return sum(self.amounts.values())
+
+    @property
+    def resident(self):
+        return self.total - self._sum(*self.MMAP)
+
+    def __repr__(self):
+        return f"<ResourceUsage total {self.total}, resident {self.resident}>"
+
+
+class TranslationUnitCache:
+    """
+    An LRU cache of TranslationUnits keyed by file name, arguments, parse
+    options and a hash of the file contents (and unsaved files), bounded by
+    the resident memory (ResourceUsage.resident) of the cached units.
+
+    When the budget is exceeded the least recently used units are dropped,
+    never the one just requested. With save_dir, dropped units are saved
+    there as AST files and a later miss with the same key reloads them
+    instead of parsing. Changes to included headers are not part of the key.
+    """
+
+    def __init__(self, budget, index=None, save_dir=None):
+        self.budget = budget
+        self.index = index if index is not None else Index.create()
+        self.save_dir = save_dir
+        self.size = 0
+        self.hits = 0
+        self.misses = 0
+        self.loads = 0
+        self._entries = collections.OrderedDict()
+
+    def __len__(self):
+        return len(self._entries)
+
+    @staticmethod
+    def make_key(filename, args=None, unsaved_files=None, options=0):
+        """Return the cache key of a parse request."""
+        content = hashlib.sha1()
+        unsaved = dict(unsaved_files or [])
+        if str(filename) not in unsaved:
+            with open(filename, "rb") as f:
+                content.update(f.read())
+        for name, contents in sorted(unsaved.items()):
+            if hasattr(contents, "read"):
+                contents = contents.read()
+            content.update(name.encode("utf-8") + b"\0" + contents.encode("utf-8") + b"\0")
+
+        key = repr((str(filename), list(args or []), options, content.hexdigest()))
+        return hashlib.sha1(key.encode("utf-8")).hexdigest()
+
+    def _path(self, key):
+        return os.path.join(self.save_dir, key + ".ast")
+
+    def get(self, filename, args=None, unsaved_files=None, options=0):
+        """Return the TranslationUnit of filename, parsed with
+        TranslationUnit.from_source unless cached or saved."""
+        # File-like contents can only be read once; the key and the parse
+        # both need them.
+        unsaved_files = _CXUnsavedFile.read(unsaved_files)
+        key = self.make_key(filename, args, unsaved_files, options)
+        if key in self._entries:
+            self._entries.move_to_end(key)
+            self.hits += 1
+            return self._entries[key][0]
+
+        self.misses += 1
+        tu = None
+        if self.save_dir is not None and os.path.exists(self._path(key)):
+            try:
+                tu = TranslationUnit.from_ast_file(self._path(key), self.index)
+                self.loads += 1
+            except TranslationUnitLoadError:
+                tu = None
+        if tu is None:
+            tu = TranslationUnit.from_source(
+                filename, args, unsaved_files, options, self.index
+            )
+
+        size = tu.get_resource_usage().resident
+        self._entries[key] = (tu, size)
+        self.size += size
+        self._evict()
+        return tu
+
+    def _evict(self):
+        while self.size > self.budget and len(self._entries) > 1:
+            key, (tu, size) = self._entries.popitem(last=False)
+            self.size -= size
+            if self.save_dir is not None and not os.path.exists(self._path(key)):
+                try:
+                    tu.save(self._path(key))
+                except TranslationUnitSaveError:
+                    pass
+
+    def clear(self):
+        """Drop every cached unit, without saving."""
+        self._entries.clear()
+        self.size = 0
+
+
+class HeaderDedupStats(Structure):
+    """
+    Header and top-level declaration counts of a HeaderDedup: num_headers
+    headers with declarations were met, num_skipped_headers of them already
+    seen, and num_declarations were kept while num_skipped_declarations were
+    skipped.
+    """
+
+    _fields_ = [
+        ("num_headers", c_uint),
+        ("num_skipped_headers", c_uint),
+        ("num_declarations", c_uint),
+        ("num_skipped_declarations", c_uint),
+    ]
+
+    def __repr__(self):
+        return (
+            f"<HeaderDedupStats headers {self.num_headers} "
+            f"({self.num_skipped_headers} skipped), declarations "
+            f"{self.num_declarations} ({self.num_skipped_declarations} skipped)>"
+        )
+
+
+class HeaderDedup(ClangObject):
+    """
+    A session indexing many translation units, where the top-level
+    declarations of each header are handed out once. Headers are identified
+    by file, content hash and macro context (predefined and command-line
+    macros, plus the external macros the header expands when the unit is
+    parsed with PARSE_DETAILED_PROCESSING_RECORD), so a header seen with
+    another configuration is visited again.
+    """
+
+    def __init__(self):
+        ClangObject.__init__(self, conf.sealang.clang_HeaderDedup_create())
+
+    def __del__(self):
+        conf.sealang.clang_HeaderDedup_dispose(self)
+
+    def get_children(self, tu):
+        """Return the top-level declaration cursors of tu that do not come
+        from an already seen header, and mark the headers of tu seen."""
+        count = conf.sealang.clang_HeaderDedup_collect(self, tu)
+        cursors = (Cursor * count)()
+        if count:
+            memmove(cursors, conf.sealang.clang_HeaderDedup_getCursors(self), sizeof(cursors))
+
+        children = list(cursors)
+        for cursor in children:
+            cursor._tu = tu
+        return children
+
+    def walk_preorder(self, tu):
+        """Depth-first walk of the declarations get_children keeps."""
+        for child in self.get_children(tu):
+            yield from child.walk_preorder()
+
+    @property
+    def stats(self):
+        """The HeaderDedupStats of the last translation unit."""
+        return conf.sealang.clang_HeaderDedup_getStats(self)
+
+    @property
+    def totals(self):
+        """The HeaderDedupStats summed over the session."""
+        return conf.sealang.clang_HeaderDedup_getTotals(self)
+
+    @property
+    def num_headers(self):
+        """The number of distinct headers seen in the session."""
+        return conf.sealang.clang_HeaderDedup_getNumHeaders(self)
+
+
+class LineColumn(Structure):
+    """
+    A (file, line, column, offset) position of a LocationMap. file indexes
+    LocationMap.files and is LocationMap.INVALID_FILE for invalid locations.
+    """
+
+    _fields_ = [
+        ("file", c_uint),
+        ("line", c_uint),
+        ("column", c_uint),
+        ("offset", c_uint),
+    ]
+
+    def __repr__(self):
+        return (
+            f"<LineColumn file {self.file}, line {self.line}, "
+            f"column {self.column}>"
+        )
+
+
+class LocationMap(ClangObject):
+    """
+    Maps arrays of cursors, source locations or file offsets of a
+    translation unit to LineColumn arrays with one native call each. A
+    line-start index is built per file the first time it is needed, so
+    the cost per location is a binary search at most.
+    """
+
+    # Cursor positions.
+    LOCATION = 0
+    EXTENT_START = 1
+    EXTENT_END = 2
+
+    INVALID_FILE = 0xFFFFFFFF
+
+    def __init__(self, tu):
+        ClangObject.__init__(self, conf.sealang.clang_LocationMap_create(tu))
+        self._tu = tu
+
+    def __del__(self):
+        conf.sealang.clang_LocationMap_dispose(self)
+
+    @property
+    def files(self):
+        """The file names, indexed by file id. Files are numbered as they are
+        met."""
+        return [
+            conf.sealang.clang_LocationMap_getFileName(self, i)
+            for i in range(conf.sealang.clang_LocationMap_getNumFiles(self))
+        ]
+
+    def get_file_id(self, filename):
+        """Return the file id of a file of the translation unit, or None."""
+        file_id = conf.sealang.clang_LocationMap_getFileId(self, filename)
+        return file_id if file_id >= 0 else None
+
+    def map_cursors(self, cursors, position=LOCATION):
+        """Map the location, extent start or extent end of every cursor.
+        Returns a LineColumn array."""
+        cursors = list(cursors)
+        array = (Cursor * len(cursors))(*cursors)
+        result = (LineColumn * len(cursors))()
+        conf.sealang.clang_LocationMap_mapCursors(
+            self, array, len(cursors), position, result
+        )
+        return result
+
+    def map_locations(self, locations):
+        """Map SourceLocations of the translation unit. Returns a LineColumn
+        array."""
+        locations = list(locations)
+        array = (SourceLocation * len(locations))(*locations)
+        result = (LineColumn * len(locations))()
+        conf.sealang.clang_LocationMap_mapLocations(
+            self, array, len(locations), result
+        )
+        return result
+
+    def map_offsets(self, file, offsets):
+        """Map byte offsets of a file, given by name or id. Returns a
+        LineColumn array."""
+        if not isinstance(file, int):
+            file_id = self.get_file_id(file)
+            file = self.INVALID_FILE if file_id is None else file_id
+
+        offsets = list(offsets)
+        array = (c_uint * len(offsets))(*offsets)
+        result = (LineColumn * len(offsets))()
+        conf.sealang.clang_LocationMap_mapOffsets(
+            self, file, array, len(offsets), result
+        )
+        return result
+
+
+class TopCompletionResult(Structure):
+    _fields_ = [
+        ("kind_id", c_uint),
+        ("priority", c_uint),
+        ("availability_id", c_uint),
+        ("score", c_int),
+        ("typed_text", c_uint),
+        ("result_type", c_uint),
+        ("signature", c_uint),
+    ]
+
+
+class Completion:
+    """
+    A result of TranslationUnit.complete. typed_text is the text to insert,
+    result_type the type of the completed entity and signature the rest of
+    the completion string, e.g. "max(int a, int b)". Lower priority values
+    are better; higher scores are better matches of the prefix.
+    """
+
+    def __init__(self, info, strings):
+        def string(offset):
+            return strings[offset:strings.index(b"\0", offset)].decode("utf-8")
+
+        self.kind = CursorKind.from_id(info.kind_id)
+        self.priority = info.priority
+        self.availability = AvailabilityKind.from_id(info.availability_id)
+        self.score = info.score
+        self.typed_text = string(info.typed_text)
+        self.result_type = string(info.result_type)
+        self.signature = string(info.signature)
+
+    def __repr__(self):
+        return f"<Completion {self.typed_text!r}, {self.result_type} {self.signature}>"
+
+
+class TopCompletions(ClangObject):
+    """
+    The ranked results of TranslationUnit.complete. num_candidates is the
+    number of results clang produced before filtering.
+    """
+
+    def __del__(self):
+        conf.sealang.clang_TopCompletions_dispose(self)
+
+    @property
+    def num_candidates(self):
+        return conf.sealang.clang_TopCompletions_getNumCandidates(self)
+
+    @CachedProperty
+    def results(self):
+        """The list of Completions, best first."""
+        count = conf.sealang.clang_TopCompletions_getNumResults(self)
+        infos = (TopCompletionResult * count)()
+        if not count:
+            return []
+
+        memmove(infos, conf.sealang.clang_TopCompletions_getResults(self), sizeof(infos))
+        length = c_uint()
+        strings = string_at(
+            conf.sealang.clang_TopCompletions_getStrings(self, byref(length)),
+            length.value,
+        )
+        return [Completion(info, strings) for info in infos]
+
+    def __len__(self):
+        return len(self.results)
+
+    def __getitem__(self, key):
+        return self.results[key]
+
+    def __iter__(self):
+        return iter(self.results)
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return TopCompletions(res)
+
+
+class OMPDirectiveInfo(Structure):
+    """
+    An OpenMP directive of OpenMPDirectives, as returned by the native API.
+    """
+
+    STANDALONE = 0x1
+    LOOP = 0x2
+
+    _fields_ = [
+        ("kind_id", c_uint),
+        ("parent", c_int),
+        ("depth", c_uint),
+        ("flags", c_uint),
+        ("name", c_uint),
+        ("collapse", c_uint),
+        ("first_clause", c_uint),
+        ("num_clauses", c_uint),
+    ]
+
+
+class OMPClauseInfo(Structure):
+    """
+    A clause of an OpenMP directive, as returned by the native API.
+    """
+
+    _fields_ = [
+        ("kind_id", c_uint),
+        ("name", c_uint),
+        ("modifier", c_uint),
+        ("first_variable", c_uint),
+        ("num_variables", c_uint),
+        ("first_argument", c_uint),
+        ("num_arguments", c_uint),
+    ]
+
+
+class OpenMPClause:
+    """
+    A clause of an OpenMPDirective, e.g. "schedule" or "reduction". modifier
+    is the schedule, default, proc_bind, depend or map kind, or the reduction
+    identifier ("+", "max"...), and an empty string otherwise. variables are
+    the declaration cursors of the variables the clause names, arguments its
+    integer constant arguments, such as the collapse count or chunk size.
+    """
+
+    def __init__(self, info, name, modifier, variables, arguments):
+        self.kind_id = info.kind_id
+        self.name = name
+        self.modifier = modifier
+        self.variables = variables
+        self.arguments = arguments
+
+    def __repr__(self):
+        return f"<OpenMPClause {self.name}>"
+
+
+class OpenMPDirective:
+    """
+    An executable OpenMP directive of OpenMPDirectives. parent and children
+    are indexes into OpenMPDirectives.directives. associated is the outermost
+    loop of loop directives, the structured block of the others and None for
+    standalone directives; collapse is the number of loops a loop directive
+    applies to.
+    """
+
+    def __init__(self, info, name, cursor, associated, clauses):
+        self.cursor = cursor
+        self.kind = CursorKind.from_id(info.kind_id)
+        self.name = name
+        self.parent = info.parent if info.parent >= 0 else None
+        self.children = []
+        self.depth = info.depth
+        self.is_standalone = bool(info.flags & OMPDirectiveInfo.STANDALONE)
+        self.is_loop = bool(info.flags & OMPDirectiveInfo.LOOP)
+        self.collapse = info.collapse
+        self.associated = associated
+        self.clauses = clauses
+
+    def get_clause(self, name):
+        """Return the first clause named name, or None."""
+        for clause in self.clauses:
+            if clause.name == name:
+                return clause
+        return None
+
+    def __repr__(self):
+        return f"<OpenMPDirective {self.name}, line {self.cursor.location.line}>"
+
+
+class OpenMPDirectives(ClangObject):
+    """
+    The OpenMP directives of a translation unit. Create with
+    TranslationUnit.get_openmp_directives.
+    """
+
+    # Options.
+    MAIN_FILE_ONLY = 0x1
+
+    def __del__(self):
+        conf.sealang.clang_OMPDirectives_dispose(self)
+
+    def _cursors(self, getter, count):
+        cursors = (Cursor * count)()
+        if count:
+            memmove(cursors, getter(self), sizeof(cursors))
+
+        result = []
+        for cursor in cursors:
+            if cursor.kind == CursorKind.INVALID_FILE:
+                result.append(None)
+                continue
+            cursor._tu = self._tu
+            result.append(cursor)
+        return result
+
+    def _array(self, element, getter, count):
+        array = (element * count)()
+        if count:
+            memmove(array, getter(self), sizeof(array))
+        return array
+
+    @CachedProperty
+    def directives(self):
+        """The list of OpenMPDirectives, in preorder."""
+        sealang = conf.sealang
+        count = sealang.clang_OMPDirectives_getNumDirectives(self)
+        if not count:
+            return []
+
+        infos = self._array(
+            OMPDirectiveInfo, sealang.clang_OMPDirectives_getDirectives, count
+        )
+        cursors = self._cursors(sealang.clang_OMPDirectives_getCursors, count)
+        associated = self._cursors(sealang.clang_OMPDirectives_getAssociated, count)
+        clause_infos = self._array(
+            OMPClauseInfo,
+            sealang.clang_OMPDirectives_getClauses,
+            sealang.clang_OMPDirectives_getNumClauses(self),
+        )
+        variables = self._cursors(
+            sealang.clang_OMPDirectives_getVariables,
+            sealang.clang_OMPDirectives_getNumVariables(self),
+        )
+        arguments = list(
+            self._array(
+                c_longlong,
+                sealang.clang_OMPDirectives_getArguments,
+                sealang.clang_OMPDirectives_getNumArguments(self),
+            )
+        )
+        length = c_uint()
+        strings = string_at(
+            sealang.clang_OMPDirectives_getStrings(self, byref(length)), length.value
+        )
+
+        def string(offset):
+            return strings[offset:strings.index(b"\0", offset)].decode("utf-8")
+
+        clauses = []
+        for info in clause_infos:
+            first_variable = info.first_variable
+            first_argument = info.first_argument
+            clauses.append(
+                OpenMPClause(
+                    info,
+                    string(info.name),
+                    string(info.modifier),
+                    variables[first_variable:first_variable + info.num_variables],
+                    arguments[first_argument:first_argument + info.num_arguments],
+                )
+            )
+
+        directives = []
+        for info, cursor, stmt in zip(infos, cursors, associated):
+            first = info.first_clause
+            directive = OpenMPDirective(
+                info,
+                string(info.name),
+                cursor,
+                stmt,
+                clauses[first:first + info.num_clauses],
+            )
+            if directive.parent is not None:
+                directives[directive.parent].children.append(len(directives))
+            directives.append(directive)
+        return directives
+
+    @property
+    def roots(self):
+        """The outermost OpenMPDirectives."""
+        return [directive for directive in self.directives if directive.parent is None]
+
+    def __len__(self):
+        return len(self.directives)
+
+    def __getitem__(self, key):
+        return self.directives[key]
+
+    def __iter__(self):
+        return iter(self.directives)
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return OpenMPDirectives(res)
+
+
+class CompilationDatabaseError(Exception):
+    """Represents an error that occurred when working with a CompilationDatabase
+
+    Each error is associated to an enumerated value, accessible under
+    e.cdb_error. Consumers can compare the value with one of the ERROR_
+    constants in this class.
+    """
+
+    # An unknown error occurred
+    ERROR_UNKNOWN = 0
+
+    # The database could not be loaded
+    ERROR_CANNOTLOADDATABASE = 1
+
+    def __init__(self, enumeration, message):
+        assert isinstance(enumeration, int)
+
+        if enumeration > 1:
+            raise Exception(
+                "Encountered undefined CompilationDatabase error "
+                f"constant: {enumeration:d}. Please file a bug to have this "
+                "value supported."
+            )
+
+        self.cdb_error = enumeration
+        Exception.__init__(self, f"Error {enumeration:d}: {message}")
+
+
+class CompileCommand:
+    """Represents the compile command used to build a file"""
+
+    def __init__(self, cmd, ccmds):
+        self.cmd = cmd
+        # Keep a reference to the originating CompileCommands
+        # to prevent garbage collection
+        self.ccmds = ccmds
+
+    @property
+    def directory(self):
+        """Get the working directory for this CompileCommand"""
+        return conf.lib.clang_CompileCommand_getDirectory(self.cmd)
+
+    @property
+    def filename(self):
+        """Get the working filename for this CompileCommand"""
+        return conf.lib.clang_CompileCommand_getFilename(self.cmd)
+
+    @property
+    def arguments(self):
+        """
+        Get an iterable object providing each argument in the
+        command line for the compiler invocation as a _CXString.
+
+        Invariant : the first argument is the compiler executable
+        """
+        length = conf.lib.clang_CompileCommand_getNumArgs(self.cmd)
+        for i in range(length):
+            yield conf.lib.clang_CompileCommand_getArg(self.cmd, i)
+
+
+class CompileCommands:
+    """
+    CompileCommands is an iterable object containing all CompileCommand
+    that can be used for building a specific file.
+    """
+
+    def __init__(self, ccmds):
+        self.ccmds = ccmds
+
+    def __del__(self):
+        conf.lib.clang_CompileCommands_dispose(self.ccmds)
+
+    def __len__(self):
+        return int(conf.lib.clang_CompileCommands_getSize(self.ccmds))
+
+    def __getitem__(self, i):
+        cc = conf.lib.clang_CompileCommands_getCommand(self.ccmds, i)
+        if not cc:
+            raise IndexError
+        return CompileCommand(cc, self)
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            return None
+        return CompileCommands(res)
+
+
+class CompilationDatabase(ClangObject):
+    """
+    The CompilationDatabase is a wrapper class around
+    clang::tooling::CompilationDatabase
+
+    It enables querying how a specific source file can be built.
+    """
+
+    def __del__(self):
+        conf.lib.clang_CompilationDatabase_dispose(self)
+
+    @staticmethod
+    def from_result(res, fn, args):
+        if not res:
+            raise CompilationDatabaseError(
+                0, "CompilationDatabase loading failed"
+            )
+        return CompilationDatabase(res)
+
+    @staticmethod
+    def fromDirectory(buildDir):
+        """Builds a CompilationDatabase from the database found in buildDir"""
+        errorCode = c_uint()
+        try:
+            cdb = conf.lib.clang_CompilationDatabase_fromDirectory(
+                buildDir, byref(errorCode)
+            )
+        except CompilationDatabaseError:
+            raise CompilationDatabaseError(
+                int(errorCode.value), "CompilationDatabase loading failed"
+            )
+        return cdb
+
+    def getCompileCommands(self, filename):
+        """
+        Get an iterable object providing all the CompileCommands available to
+        build filename. Returns None if filename is not found in the database.
+        """
+        return conf.lib.clang_CompilationDatabase_getCompileCommands(
+            self, filename
+        )
+
+    def getAllCompileCommands(self):
+        """
+        Get an iterable object providing all the CompileCommands available from
+        the database.
+        """
+        return conf.lib.clang_CompilationDatabase_getAllCompileCommands(self)
+
+
+class Token(Structure):
+    """Represents a single token from the preprocessor.
 
     Tokens are effectively segments of source code. Source code is first parsed
     into tokens before being converted into the AST and Cursors.
@@ -3560,6 +5206,20 @@ functionList = [
         _CXString.from_result,
     ),
     ("clang_CompileCommand_getNumArgs", [c_object_p], c_uint),
+    ("clang_CloneIndex_add", [CloneIndex, SubtreeHashes]),
+    ("clang_CloneIndex_computeBuckets", [CloneIndex, c_uint], c_uint),
+    ("clang_CloneIndex_create", [], c_object_p),
+    ("clang_CloneIndex_dispose", [CloneIndex]),
+    ("clang_CloneIndex_getBuckets", [CloneIndex], POINTER(CloneBucket)),
+    (
+        "clang_CloneIndex_getFileName",
+        [CloneIndex, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_CloneIndex_getNumFiles", [CloneIndex], c_uint),
+    ("clang_CloneIndex_getNumRecords", [CloneIndex], c_uint),
+    ("clang_CloneIndex_getRecords", [CloneIndex], POINTER(SubtreeHash)),
     (
         "clang_codeCompleteAt",
         [TranslationUnit, c_interop_string, c_int, c_int, c_void_p, c_int, c_int],
@@ -3571,6 +5231,22 @@ functionList = [
         Diagnostic,
     ),
     ("clang_codeCompleteGetNumDiagnostics", [CodeCompletionResults], c_int),
+    (
+        "clang_codeCompleteTopK",
+        [
+            TranslationUnit,
+            c_interop_string,
+            c_uint,
+            c_uint,
+            c_void_p,
+            c_uint,
+            c_uint,
+            c_interop_string,
+            c_uint,
+        ],
+        c_object_p,
+        TopCompletions.from_result,
+    ),
     ("clang_createIndex", [c_int, c_int], c_object_p),
     ("clang_createTranslationUnit", [Index, c_interop_string], c_object_p),
     ("clang_CXXConstructor_isConvertingConstructor", [Cursor], bool),
@@ -3587,9 +5263,15 @@ functionList = [
     ("clang_EnumDecl_isScoped", [Cursor], bool),
     ("clang_defaultDiagnosticDisplayOptions", [], c_uint),
     ("clang_defaultSaveOptions", [TranslationUnit], c_uint),
+    ("clang_DispatchTable_addInterest", [DispatchTable, c_uint, c_int, c_int]),
+    ("clang_DispatchTable_collect", [DispatchTable, Cursor], c_uint),
+    ("clang_DispatchTable_collectMany", [DispatchTable, c_void_p, c_uint], c_uint),
+    ("clang_DispatchTable_create", [c_uint], c_object_p),
+    ("clang_DispatchTable_dispose", [DispatchTable]),
+    ("clang_DispatchTable_getMatches", [DispatchTable, c_uint], POINTER(Cursor)),
+    ("clang_DispatchTable_getNumMatches", [DispatchTable, c_uint], c_uint),
     ("clang_disposeCodeCompleteResults", [CodeCompletionResults]),
-    # ("clang_disposeCXTUResourceUsage",
-    #  [CXTUResourceUsage]),
+    ("clang_disposeCXTUResourceUsage", [CXTUResourceUsage]),
     ("clang_disposeDiagnostic", [Diagnostic]),
     ("clang_disposeIndex", [Index]),
     ("clang_disposeString", [_CXString]),
@@ -3682,9 +5364,18 @@ functionList = [
         "clang_Cursor_getBinaryOpcode",
         [Cursor],
     ),
-    # ("clang_getCXTUResourceUsage",
-    #  [TranslationUnit],
-    #  CXTUResourceUsage),
+    (
+        "clang_Cursor_printSource",
+        [Cursor, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    (
+        "clang_Cursor_getStructuralHash",
+        [Cursor, c_uint, POINTER(c_uint)],
+        c_ulonglong,
+    ),
+    ("clang_getCXTUResourceUsage", [TranslationUnit], CXTUResourceUsage),
     ("clang_getCXXAccessSpecifier", [Cursor], c_uint),
     (
         "clang_getDeclObjCTypeEncoding",
@@ -3814,6 +5505,43 @@ functionList = [
     ("clang_getTypeKindSpelling", [c_uint], _CXString, _CXString.from_result),
     ("clang_getTypeSpelling", [Type], _CXString, _CXString.from_result),
     ("clang_hashCursor", [Cursor], c_uint),
+    ("clang_HeaderDedup_collect", [HeaderDedup, TranslationUnit], c_uint),
+    ("clang_HeaderDedup_create", [], c_object_p),
+    ("clang_HeaderDedup_dispose", [HeaderDedup]),
+    ("clang_HeaderDedup_getCursors", [HeaderDedup], POINTER(Cursor)),
+    ("clang_HeaderDedup_getNumHeaders", [HeaderDedup], c_uint),
+    ("clang_HeaderDedup_getStats", [HeaderDedup], HeaderDedupStats),
+    ("clang_HeaderDedup_getTotals", [HeaderDedup], HeaderDedupStats),
+    ("clang_IncludeCostTable_add", [IncludeCostTable, IncludeGraph]),
+    ("clang_IncludeCostTable_create", [], c_object_p),
+    ("clang_IncludeCostTable_dispose", [IncludeCostTable]),
+    (
+        "clang_IncludeCostTable_getEntries",
+        [IncludeCostTable],
+        POINTER(IncludeCostEntry),
+    ),
+    (
+        "clang_IncludeCostTable_getFileName",
+        [IncludeCostTable, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_IncludeCostTable_getNumFiles", [IncludeCostTable], c_uint),
+    ("clang_IncludeGraph_dispose", [IncludeGraph]),
+    ("clang_IncludeGraph_getEdges", [IncludeGraph], POINTER(IncludeEdge)),
+    (
+        "clang_IncludeGraph_getFileName",
+        [IncludeGraph, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    (
+        "clang_IncludeGraph_getFileStats",
+        [IncludeGraph],
+        POINTER(IncludeFileStats),
+    ),
+    ("clang_IncludeGraph_getNumEdges", [IncludeGraph], c_uint),
+    ("clang_IncludeGraph_getNumFiles", [IncludeGraph], c_uint),
     ("clang_isAttribute", [CursorKind], bool),
     ("clang_isConstQualifiedType", [Type], bool),
     ("clang_isCursorDefinition", [Cursor], bool),
@@ -3831,17 +5559,165 @@ functionList = [
     ("clang_isUnexposed", [CursorKind], bool),
     ("clang_isVirtualBase", [Cursor], bool),
     ("clang_isVolatileQualifiedType", [Type], bool),
+    ("clang_LocationMap_create", [TranslationUnit], c_object_p),
+    ("clang_LocationMap_dispose", [LocationMap]),
+    ("clang_LocationMap_getFileId", [LocationMap, c_interop_string], c_int),
+    (
+        "clang_LocationMap_getFileName",
+        [LocationMap, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_LocationMap_getNumFiles", [LocationMap], c_uint),
+    (
+        "clang_LocationMap_mapCursors",
+        [LocationMap, c_void_p, c_uint, c_uint, POINTER(LineColumn)],
+    ),
+    (
+        "clang_LocationMap_mapLocations",
+        [LocationMap, c_void_p, c_uint, POINTER(LineColumn)],
+    ),
+    (
+        "clang_LocationMap_mapOffsets",
+        [LocationMap, c_uint, c_void_p, c_uint, POINTER(LineColumn)],
+    ),
+    ("clang_LoopNest_dispose", [LoopNest]),
+    ("clang_LoopNest_getArrays", [LoopNest], POINTER(Cursor)),
+    ("clang_LoopNest_getCursors", [LoopNest], POINTER(Cursor)),
+    ("clang_LoopNest_getInductionVariables", [LoopNest], POINTER(Cursor)),
+    ("clang_LoopNest_getLoops", [LoopNest], POINTER(LoopInfo)),
+    ("clang_LoopNest_getNumArrays", [LoopNest], c_uint),
+    ("clang_LoopNest_getNumLoops", [LoopNest], c_uint),
+    ("clang_MacroIndex_dispose", [MacroIndex]),
+    ("clang_MacroIndex_findDefinition", [MacroIndex, c_interop_string], c_int),
+    (
+        "clang_MacroIndex_getDefinitionName",
+        [MacroIndex, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    (
+        "clang_MacroIndex_getDefinitions",
+        [MacroIndex],
+        POINTER(MacroDefinitionInfo),
+    ),
+    (
+        "clang_MacroIndex_getExpansions",
+        [MacroIndex],
+        POINTER(MacroExpansionInfo),
+    ),
+    (
+        "clang_MacroIndex_getFileName",
+        [MacroIndex, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_MacroIndex_getNumDefinitions", [MacroIndex], c_uint),
+    ("clang_MacroIndex_getNumExpansions", [MacroIndex], c_uint),
+    ("clang_MacroIndex_getNumFiles", [MacroIndex], c_uint),
+    ("clang_OMPDirectives_dispose", [OpenMPDirectives]),
+    ("clang_OMPDirectives_getArguments", [OpenMPDirectives], POINTER(c_longlong)),
+    ("clang_OMPDirectives_getAssociated", [OpenMPDirectives], POINTER(Cursor)),
+    ("clang_OMPDirectives_getClauses", [OpenMPDirectives], POINTER(OMPClauseInfo)),
+    ("clang_OMPDirectives_getCursors", [OpenMPDirectives], POINTER(Cursor)),
+    (
+        "clang_OMPDirectives_getDirectives",
+        [OpenMPDirectives],
+        POINTER(OMPDirectiveInfo),
+    ),
+    ("clang_OMPDirectives_getNumArguments", [OpenMPDirectives], c_uint),
+    ("clang_OMPDirectives_getNumClauses", [OpenMPDirectives], c_uint),
+    ("clang_OMPDirectives_getNumDirectives", [OpenMPDirectives], c_uint),
+    ("clang_OMPDirectives_getNumVariables", [OpenMPDirectives], c_uint),
+    ("clang_OMPDirectives_getStrings", [OpenMPDirectives, POINTER(c_uint)], c_void_p),
+    ("clang_OMPDirectives_getVariables", [OpenMPDirectives], POINTER(Cursor)),
+    ("clang_ParentMap_create", [], c_object_p),
+    ("clang_ParentMap_dispose", [ParentMap]),
+    (
+        "clang_ParentMap_getEnclosing",
+        [ParentMap, Cursor, c_int],
+        Cursor,
+        Cursor.from_result,
+    ),
+    (
+        "clang_ParentMap_getParent",
+        [ParentMap, Cursor],
+        Cursor,
+        Cursor.from_result,
+    ),
     (
         "clang_parseTranslationUnit",
         [Index, c_interop_string, c_void_p, c_int, c_void_p, c_int, c_int],
         c_object_p,
     ),
+    (
+        "clang_printCursors",
+        [c_void_p, c_uint, c_uint],
+        c_object_p,
+        PrintBuffer.from_result,
+    ),
+    ("clang_PrintBuffer_dispose", [PrintBuffer]),
+    ("clang_PrintBuffer_getData", [PrintBuffer, POINTER(c_uint)], c_void_p),
+    ("clang_PrintBuffer_getOffsets", [PrintBuffer], POINTER(c_uint)),
+    (
+        "clang_profileIncludeGraph",
+        [c_interop_string, c_void_p, c_int, c_void_p, c_uint],
+        c_object_p,
+        IncludeGraph.from_result,
+    ),
+    ("clang_RewriteBatch_addEdits", [RewriteBatch, c_void_p, c_void_p, c_uint]),
+    ("clang_RewriteBatch_addFixIts", [RewriteBatch], c_uint),
+    ("clang_RewriteBatch_apply", [RewriteBatch], c_uint),
+    ("clang_RewriteBatch_create", [TranslationUnit], c_object_p),
+    ("clang_RewriteBatch_dispose", [RewriteBatch]),
+    ("clang_RewriteBatch_getBuffer", [RewriteBatch, c_uint, POINTER(c_uint)], c_void_p),
+    (
+        "clang_RewriteBatch_getFileName",
+        [RewriteBatch, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_RewriteBatch_getNumFiles", [RewriteBatch], c_uint),
+    (
+        "clang_RewriteBatch_getRejections",
+        [RewriteBatch],
+        POINTER(RewriteRejection),
+    ),
     (
         "clang_reparseTranslationUnit",
         [TranslationUnit, c_int, c_void_p, c_int],
         c_int,
     ),
     ("clang_saveTranslationUnit", [TranslationUnit, c_interop_string, c_uint], c_int),
+    ("clang_SubtreeHashes_dispose", [SubtreeHashes]),
+    (
+        "clang_SubtreeHashes_getCursor",
+        [SubtreeHashes, c_uint],
+        Cursor,
+        Cursor.from_result,
+    ),
+    (
+        "clang_SubtreeHashes_getFileName",
+        [SubtreeHashes, c_uint],
+        _CXString,
+        _CXString.from_result,
+    ),
+    ("clang_SubtreeHashes_getNumFiles", [SubtreeHashes], c_uint),
+    ("clang_SubtreeHashes_getNumRecords", [SubtreeHashes], c_uint),
+    ("clang_SubtreeHashes_getRecords", [SubtreeHashes], POINTER(SubtreeHash)),
+    ("clang_TopCompletions_dispose", [TopCompletions]),
+    ("clang_TopCompletions_getNumCandidates", [TopCompletions], c_uint),
+    ("clang_TopCompletions_getNumResults", [TopCompletions], c_uint),
+    (
+        "clang_TopCompletions_getResults",
+        [TopCompletions],
+        POINTER(TopCompletionResult),
+    ),
+    (
+        "clang_TopCompletions_getStrings",
+        [TopCompletions, POINTER(c_uint)],
+        c_void_p,
+    ),
     (
         "clang_tokenize",
         [
@@ -3851,6 +5727,36 @@ functionList = [
             POINTER(c_uint),
         ],
     ),
+    (
+        "clang_TranslationUnit_getIncludeGraph",
+        [TranslationUnit],
+        c_object_p,
+        IncludeGraph.from_result,
+    ),
+    (
+        "clang_TranslationUnit_getLoopNest",
+        [TranslationUnit, c_uint],
+        c_object_p,
+        LoopNest.from_result,
+    ),
+    (
+        "clang_TranslationUnit_getMacroIndex",
+        [TranslationUnit],
+        c_object_p,
+        MacroIndex.from_result,
+    ),
+    (
+        "clang_TranslationUnit_getOMPDirectives",
+        [TranslationUnit, c_uint],
+        c_object_p,
+        OpenMPDirectives.from_result,
+    ),
+    (
+        "clang_TranslationUnit_getSubtreeHashes",
+        [TranslationUnit, c_uint, c_uint],
+        c_object_p,
+        SubtreeHashes.from_result,
+    ),
     (
         "clang_visitChildren",
         [Cursor, callbacks["cursor_visit"], py_object],
@@ -4084,25 +5990,58 @@ register_enumerations()
 __all__ = [
     "AvailabilityKind",
     "BinaryOperator",
+    "CloneIndex",
     "CodeCompletionResults",
     "CompilationDatabase",
     "CompileCommand",
     "CompileCommands",
+    "Completion",
     "Config",
     "Cursor",
     "CursorKind",
     "Diagnostic",
+    "DispatchTable",
     "File",
     "FixIt",
+    "HeaderDedup",
+    "HeaderDedupStats",
+    "IncludeCostEntry",
+    "IncludeCostTable",
+    "IncludeEdge",
+    "IncludeFileStats",
+    "IncludeGraph",
     "Index",
+    "LineColumn",
     "LinkageKind",
+    "LocationMap",
+    "Loop",
+    "LoopInfo",
+    "LoopNest",
+    "MacroDefinitionInfo",
+    "MacroExpansionInfo",
+    "MacroIndex",
+    "OpenMPClause",
+    "OpenMPDirective",
+    "OpenMPDirectives",
+    "ParentMap",
+    "PrintSource",
+    "ResourceUsage",
+    "RewriteBatch",
+    "RewriteRejection",
+    "Rule",
+    "RuleEngine",
     "SourceLocation",
     "SourceRange",
     "StorageClass",
+    "StructuralHash",
+    "SubtreeHash",
+    "SubtreeHashes",
     "TLSKind",
     "Token",
     "TokenKind",
+    "TopCompletions",
     "TranslationUnit",
+    "TranslationUnitCache",
     "TranslationUnitLoadError",
     "Type",
     "TypeKind",
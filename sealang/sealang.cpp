@@ -4,7 +4,50 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/ExprObjC.h"
+#include "clang/AST/ExprOpenMP.h"
+#include "clang/AST/OpenMPClause.h"
+#include "clang/AST/ParentMap.h"
+#include "clang/AST/PrettyPrinter.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/StmtOpenMP.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/OpenMPKinds.h"
+#include "clang/Basic/OperatorKinds.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Config/config.h"
+#include "clang/Driver/Driver.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/PreprocessingRecord.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Rewrite/Core/Rewriter.h"
+#include "clang/Sema/CodeCompleteConsumer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/xxhash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
 
 /************************************************************************
  * Duplicated libclang functionality
@@ -14,7 +57,21 @@
  * party libraries.
  ************************************************************************/
 
+struct CXTranslationUnitImpl {
+    void *CIdx;
+    clang::ASTUnit *TheASTUnit;
+    // The remaining members are private to libclang and never accessed here.
+};
+
 namespace clang {
+    namespace cxtu {
+        ASTUnit *getASTUnit(CXTranslationUnit TU) {
+            if (!TU)
+                return nullptr;
+            return TU->TheASTUnit;
+        }
+    }
+
     enum CXStringFlag {
       /// CXString contains a 'const char *' that it doesn't own.
       CXS_Unmanaged,
@@ -95,6 +152,35 @@ namespace clang {
           return newCursor;
         }
 
+        CXCursor MakeCXCursor(const Decl *D, CXTranslationUnit TU,
+                              SourceRange RegionOfInterest = SourceRange(),
+                              bool FirstInDeclGroup = true) {
+          assert(D && TU && "Invalid arguments!");
+
+          CXCursorKind K = getCursorKindForDecl(D);
+
+          if (K == CXCursor_ObjCClassMethodDecl ||
+              K == CXCursor_ObjCInstanceMethodDecl) {
+            int SelectorIdIndex = -1;
+            // Check if cursor points to a selector id.
+            if (RegionOfInterest.isValid() &&
+                RegionOfInterest.getBegin() == RegionOfInterest.getEnd()) {
+              SmallVector<SourceLocation, 16> SelLocs;
+              cast<ObjCMethodDecl>(D)->getSelectorLocs(SelLocs);
+              SmallVectorImpl<SourceLocation>::iterator I =
+                  llvm::find(SelLocs, RegionOfInterest.getBegin());
+              if (I != SelLocs.end())
+                SelectorIdIndex = I - SelLocs.begin();
+            }
+            CXCursor C = {K, SelectorIdIndex,
+                          {D, (void *)(intptr_t)(FirstInDeclGroup ? 1 : 0), TU}};
+            return C;
+          }
+
+          CXCursor C = {K, 0, {D, (void *)(intptr_t)(FirstInDeclGroup ? 1 : 0), TU}};
+          return C;
+        }
+
         CXCursor MakeCXCursor(const Stmt *S, const Decl *Parent,
                                         CXTranslationUnit TU,
                                         SourceRange RegionOfInterest = SourceRange()) {
@@ -851,6 +937,2908 @@ CXCursor clang_getForStmtBody(CXCursor cursor)
 	else return clang::cxcursor::MakeCXCursorInvalid(CXCursor_NoDeclFound);
 }
 
+/************************************************************************
+ * Include graph
+ *
+ * Compact include DAG of a translation unit, optionally annotated with the
+ * time and tokens the preprocessor and parser spent in every file.
+ ************************************************************************/
+
+namespace {
+    struct IncludeGraph {
+        std::vector<std::string> names;
+        std::vector<CXIncludeFileStats> stats;
+        std::vector<CXIncludeEdge> edges;
+        llvm::DenseMap<const clang::FileEntry *, unsigned> ids;
+
+        unsigned getFileIndex(const clang::FileEntry *file) {
+            auto it = ids.find(file);
+            if (it != ids.end())
+                return it->second;
+
+            unsigned index = names.size();
+            ids[file] = index;
+            names.push_back(file->getName().str());
+
+            CXIncludeFileStats entry = {};
+            entry.depth = ~0U;
+            entry.size = file->getSize();
+            stats.push_back(entry);
+            return index;
+        }
+
+        void addEdge(const clang::SourceManager &SM, const clang::FileEntry *includer,
+                     const clang::FileEntry *included, clang::SourceLocation loc) {
+            loc = SM.getExpansionLoc(loc);
+            CXIncludeEdge edge;
+            edge.includer = getFileIndex(includer);
+            edge.included = getFileIndex(included);
+            edge.line = SM.getSpellingLineNumber(loc);
+            edge.column = SM.getSpellingColumnNumber(loc);
+            edge.offset = SM.getFileOffset(loc);
+            edges.push_back(edge);
+        }
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double elapsed(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    /// Attributes wall time to the file the preprocessor is currently lexing.
+    /// The parser only pulls tokens on demand, so the time it spends on a
+    /// declaration is charged to the file that declaration comes from.
+    class IncludeProfiler : public clang::PPCallbacks {
+        struct Frame {
+            int index;
+            Clock::time_point entered;
+        };
+
+        const clang::SourceManager &SM;
+        IncludeGraph &graph;
+        std::vector<Frame> stack;
+        Clock::time_point last;
+        clang::FileID lastTokenFile;
+        int lastTokenIndex = -1;
+
+        void charge(Clock::time_point now) {
+            if (!stack.empty() && stack.back().index >= 0)
+                graph.stats[stack.back().index].self_time += elapsed(last, now);
+            last = now;
+        }
+
+        int indexOf(clang::FileID fid) {
+            const clang::FileEntry *file = SM.getFileEntryForID(fid);
+            return file ? (int) graph.getFileIndex(file) : -1;
+        }
+
+    public:
+        IncludeProfiler(const clang::SourceManager &SM, IncludeGraph &graph)
+            : SM(SM), graph(graph), last(Clock::now()) {}
+
+        void FileChanged(clang::SourceLocation Loc, FileChangeReason Reason,
+                         clang::SrcMgr::CharacteristicKind FileType,
+                         clang::FileID PrevFID) override {
+            Clock::time_point now = Clock::now();
+            charge(now);
+
+            if (Reason == EnterFile) {
+                int index = indexOf(SM.getFileID(Loc));
+                if (index >= 0) {
+                    unsigned depth = 0;
+                    for (const Frame &frame : stack)
+                        if (frame.index >= 0)
+                            ++depth;
+
+                    CXIncludeFileStats &entry = graph.stats[index];
+                    entry.depth = std::min(entry.depth, depth);
+                    ++entry.num_entries;
+                }
+                stack.push_back({index, now});
+            } else if (Reason == ExitFile && !stack.empty()) {
+                Frame frame = stack.back();
+                stack.pop_back();
+                if (frame.index >= 0)
+                    graph.stats[frame.index].total_time += elapsed(frame.entered, now);
+            }
+        }
+
+        void InclusionDirective(clang::SourceLocation HashLoc, const clang::Token &IncludeTok,
+                                llvm::StringRef FileName, bool IsAngled,
+                                clang::CharSourceRange FilenameRange, const clang::FileEntry *File,
+                                llvm::StringRef SearchPath, llvm::StringRef RelativePath,
+                                const clang::Module *Imported,
+                                clang::SrcMgr::CharacteristicKind FileType) override {
+            const clang::FileEntry *includer = SM.getFileEntryForID(SM.getFileID(HashLoc));
+            if (includer && File)
+                graph.addEdge(SM, includer, File, FilenameRange.getBegin());
+        }
+
+        void EndOfMainFile() override {
+            Clock::time_point now = Clock::now();
+            charge(now);
+
+            for (const Frame &frame : stack)
+                if (frame.index >= 0)
+                    graph.stats[frame.index].total_time += elapsed(frame.entered, now);
+            stack.clear();
+        }
+
+        void TokenLexed(const clang::Token &Tok) {
+            if (Tok.isAnnotation() || Tok.is(clang::tok::eof))
+                return;
+
+            clang::FileID fid = SM.getFileID(SM.getExpansionLoc(Tok.getLocation()));
+            if (fid != lastTokenFile) {
+                lastTokenFile = fid;
+                lastTokenIndex = indexOf(fid);
+            }
+            if (lastTokenIndex >= 0)
+                ++graph.stats[lastTokenIndex].num_tokens;
+        }
+    };
+
+    class IncludeProfileAction : public clang::SyntaxOnlyAction {
+        IncludeGraph &graph;
+
+    public:
+        explicit IncludeProfileAction(IncludeGraph &graph) : graph(graph) {}
+
+    protected:
+        bool BeginSourceFileAction(clang::CompilerInstance &CI) override {
+            clang::Preprocessor &PP = CI.getPreprocessor();
+            auto profiler = std::make_unique<IncludeProfiler>(CI.getSourceManager(), graph);
+            IncludeProfiler *watcher = profiler.get();
+
+            // Both the callbacks and the watcher are owned by the preprocessor.
+            PP.setTokenWatcher([watcher](const clang::Token &Tok) { watcher->TokenLexed(Tok); });
+            PP.addPPCallbacks(std::move(profiler));
+            return clang::SyntaxOnlyAction::BeginSourceFileAction(CI);
+        }
+    };
+
+    /// The location of the file name of the inclusion directive at hashLoc,
+    /// where PPCallbacks::InclusionDirective reports it.
+    clang::SourceLocation getIncludeFilenameLoc(const clang::SourceManager &SM,
+                                                const clang::LangOptions &LangOpts,
+                                                clang::SourceLocation hashLoc)
+    {
+        std::pair<clang::FileID, unsigned> decomposed = SM.getDecomposedLoc(hashLoc);
+        bool invalid = false;
+        llvm::StringRef buffer = SM.getBufferData(decomposed.first, &invalid);
+        if (invalid)
+            return hashLoc;
+
+        clang::Lexer lexer(SM.getLocForStartOfFile(decomposed.first), LangOpts,
+                           buffer.begin(), buffer.begin() + decomposed.second, buffer.end());
+        clang::Token tok;
+        lexer.LexFromRawLexer(tok);
+        lexer.LexFromRawLexer(tok);
+        lexer.LexFromRawLexer(tok);
+        return tok.isAtStartOfLine() || tok.is(clang::tok::eof) ? hashLoc : tok.getLocation();
+    }
+
+    /// Mirrors CIndexer::getClangResourcesPath: builtin headers are looked up
+    /// relative to the clang library this module is linked against.
+    std::string getClangResourcesPath() {
+#ifdef _WIN32
+        return std::string();
+#else
+        Dl_info info;
+        if (!dladdr((void *) &clang::getClangFullVersion, &info) || !info.dli_fname)
+            return std::string();
+        return clang::driver::Driver::GetResourcesPath(info.dli_fname, CLANG_RESOURCE_DIR);
+#endif
+    }
+}
+
+CXIncludeGraph clang_TranslationUnit_getIncludeGraph(CXTranslationUnit TU)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    const clang::SourceManager &SM = unit->getSourceManager();
+    clang::PreprocessingRecord *record = unit->getPreprocessor().getPreprocessingRecord();
+    IncludeGraph *graph = new IncludeGraph();
+    std::set<std::tuple<unsigned, unsigned, unsigned>> seen;
+
+    if (const clang::FileEntry *main = SM.getFileEntryForID(SM.getMainFileID()))
+        graph->stats[graph->getFileIndex(main)].depth = 0;
+
+    // As in clang_getInclusions, files from a precompiled preamble live in
+    // the loaded entries.
+    for (int local = 1; local >= 0; --local) {
+        unsigned n = local ? SM.local_sloc_entry_size() : SM.loaded_sloc_entry_size();
+        for (unsigned i = 0; i < n; ++i) {
+            bool invalid = false;
+            const clang::SrcMgr::SLocEntry &entry =
+                local ? SM.getLocalSLocEntry(i) : SM.getLoadedSLocEntry(i, &invalid);
+            if (invalid || !entry.isFile())
+                continue;
+
+            const clang::SrcMgr::FileInfo &info = entry.getFile();
+            const clang::FileEntry *included = info.getContentCache()->OrigEntry;
+            clang::SourceLocation includeLoc = info.getIncludeLoc();
+            if (!included || includeLoc.isInvalid())
+                continue;
+
+            const clang::FileEntry *includer = SM.getFileEntryForID(SM.getFileID(includeLoc));
+            if (!includer)
+                continue;
+
+            unsigned depth = 0;
+            for (clang::SourceLocation L = includeLoc; L.isValid();
+                 L = SM.getIncludeLoc(SM.getFileID(L)))
+                ++depth;
+
+            unsigned index = graph->getFileIndex(included);
+            CXIncludeFileStats &stats = graph->stats[index];
+            stats.depth = std::min(stats.depth, depth);
+            ++stats.num_entries;
+
+            auto key = std::make_tuple(graph->getFileIndex(includer), index,
+                                       SM.getFileOffset(SM.getExpansionLoc(includeLoc)));
+            if (!record && seen.insert(key).second)
+                graph->addEdge(SM, includer, included, includeLoc);
+        }
+    }
+
+    // The preprocessing record also has the directives that did not enter
+    // their file, e.g. because of an include guard, as
+    // clang_profileIncludeGraph sees them.
+    if (record) {
+        for (clang::PreprocessedEntity *entity : *record) {
+            clang::InclusionDirective *directive = clang::dyn_cast_or_null<clang::InclusionDirective>(entity);
+            if (!directive || !directive->getFile())
+                continue;
+
+            clang::SourceLocation hashLoc = directive->getSourceRange().getBegin();
+            const clang::FileEntry *includer = SM.getFileEntryForID(SM.getFileID(hashLoc));
+            if (includer)
+                graph->addEdge(SM, includer, directive->getFile(),
+                               getIncludeFilenameLoc(SM, unit->getLangOpts(), hashLoc));
+        }
+    }
+
+    return graph;
+}
+
+CXIncludeGraph clang_profileIncludeGraph(const char *source_filename,
+                                         const char *const *command_line_args,
+                                         int num_command_line_args,
+                                         struct CXUnsavedFile *unsaved_files,
+                                         unsigned num_unsaved_files)
+{
+    std::string resources = getClangResourcesPath();
+
+    std::vector<const char *> args;
+    args.push_back("clang");
+    if (!resources.empty()) {
+        args.push_back("-resource-dir");
+        args.push_back(resources.c_str());
+    }
+    args.insert(args.end(), command_line_args, command_line_args + num_command_line_args);
+    if (source_filename)
+        args.push_back(source_filename);
+    args.push_back("-fsyntax-only");
+
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diags =
+        clang::CompilerInstance::createDiagnostics(new clang::DiagnosticOptions(),
+                                                   new clang::IgnoringDiagConsumer());
+    std::shared_ptr<clang::CompilerInvocation> invocation =
+        clang::createInvocationFromCommandLine(args, diags);
+    if (!invocation)
+        return nullptr;
+
+    for (unsigned i = 0; i < num_unsaved_files; ++i) {
+        llvm::StringRef contents(unsaved_files[i].Contents, unsaved_files[i].Length);
+        invocation->getPreprocessorOpts().addRemappedFile(
+            unsaved_files[i].Filename,
+            llvm::MemoryBuffer::getMemBufferCopy(contents, unsaved_files[i].Filename).release());
+    }
+
+    clang::CompilerInstance CI;
+    CI.setInvocation(std::move(invocation));
+    CI.createDiagnostics(new clang::IgnoringDiagConsumer(), true);
+
+    // A translation unit with errors still has a meaningful include graph.
+    IncludeGraph *graph = new IncludeGraph();
+    IncludeProfileAction action(*graph);
+    CI.ExecuteAction(action);
+    return graph;
+}
+
+unsigned clang_IncludeGraph_getNumFiles(CXIncludeGraph G)
+{
+    return G ? static_cast<IncludeGraph *>(G)->names.size() : 0;
+}
+
+CXString clang_IncludeGraph_getFileName(CXIncludeGraph G, unsigned index)
+{
+    IncludeGraph *graph = static_cast<IncludeGraph *>(G);
+    if (!graph || index >= graph->names.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(graph->names[index]);
+}
+
+const CXIncludeFileStats *clang_IncludeGraph_getFileStats(CXIncludeGraph G)
+{
+    return G ? static_cast<IncludeGraph *>(G)->stats.data() : nullptr;
+}
+
+unsigned clang_IncludeGraph_getNumEdges(CXIncludeGraph G)
+{
+    return G ? static_cast<IncludeGraph *>(G)->edges.size() : 0;
+}
+
+const CXIncludeEdge *clang_IncludeGraph_getEdges(CXIncludeGraph G)
+{
+    return G ? static_cast<IncludeGraph *>(G)->edges.data() : nullptr;
+}
+
+void clang_IncludeGraph_dispose(CXIncludeGraph G)
+{
+    delete static_cast<IncludeGraph *>(G);
+}
+
+namespace {
+    struct IncludeCostTable {
+        llvm::StringMap<unsigned> ids;
+        std::vector<std::string> names;
+        std::vector<CXIncludeCostEntry> entries;
+    };
+}
+
+CXIncludeCostTable clang_IncludeCostTable_create(void)
+{
+    return new IncludeCostTable();
+}
+
+void clang_IncludeCostTable_add(CXIncludeCostTable T, CXIncludeGraph G)
+{
+    IncludeCostTable *table = static_cast<IncludeCostTable *>(T);
+    IncludeGraph *graph = static_cast<IncludeGraph *>(G);
+    if (!table || !graph)
+        return;
+
+    std::vector<unsigned> mapping(graph->names.size());
+    for (unsigned i = 0; i < graph->names.size(); ++i) {
+        auto inserted = table->ids.try_emplace(graph->names[i], table->names.size());
+        if (inserted.second) {
+            table->names.push_back(graph->names[i]);
+            CXIncludeCostEntry entry = {};
+            entry.min_depth = ~0U;
+            table->entries.push_back(entry);
+        }
+        mapping[i] = inserted.first->second;
+
+        const CXIncludeFileStats &stats = graph->stats[i];
+        CXIncludeCostEntry &entry = table->entries[mapping[i]];
+        ++entry.num_translation_units;
+        entry.min_depth = std::min(entry.min_depth, stats.depth);
+        entry.num_tokens += stats.num_tokens;
+        entry.size = stats.size;
+        entry.self_time += stats.self_time;
+        entry.total_time += stats.total_time;
+    }
+
+    for (const CXIncludeEdge &edge : graph->edges)
+        ++table->entries[mapping[edge.included]].num_includes;
+}
+
+unsigned clang_IncludeCostTable_getNumFiles(CXIncludeCostTable T)
+{
+    return T ? static_cast<IncludeCostTable *>(T)->names.size() : 0;
+}
+
+CXString clang_IncludeCostTable_getFileName(CXIncludeCostTable T, unsigned index)
+{
+    IncludeCostTable *table = static_cast<IncludeCostTable *>(T);
+    if (!table || index >= table->names.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(table->names[index]);
+}
+
+const CXIncludeCostEntry *clang_IncludeCostTable_getEntries(CXIncludeCostTable T)
+{
+    return T ? static_cast<IncludeCostTable *>(T)->entries.data() : nullptr;
+}
+
+void clang_IncludeCostTable_dispose(CXIncludeCostTable T)
+{
+    delete static_cast<IncludeCostTable *>(T);
+}
+
+/************************************************************************
+ * Cursor dispatch
+ *
+ * A single native traversal that routes every cursor to the rules that
+ * registered an interest in its kind (and operator opcode).
+ ************************************************************************/
+
+namespace {
+    struct DispatchInterest {
+        unsigned rule;
+        int opcode;
+    };
+
+    struct DispatchTable {
+        llvm::DenseMap<unsigned, llvm::SmallVector<DispatchInterest, 2>> interests;
+        std::vector<std::vector<CXCursor>> matches;
+        unsigned numMatches = 0;
+
+        void dispatch(CXCursor cursor) {
+            auto it = interests.find(cursor.kind);
+            if (it == interests.end())
+                return;
+
+            int opcode = -1;
+            bool haveOpcode = false;
+            unsigned lastRule = ~0U;
+            for (const DispatchInterest &interest : it->second) {
+                if (interest.rule == lastRule)
+                    continue;
+
+                if (interest.opcode >= 0) {
+                    if (!haveOpcode) {
+                        opcode = cursor.kind == CXCursor_UnaryOperator
+                            ? (int) clang_Cursor_getUnaryOpcode(cursor)
+                            : (int) clang_Cursor_getBinaryOpcode(cursor);
+                        haveOpcode = true;
+                    }
+                    if (interest.opcode != opcode)
+                        continue;
+                }
+
+                matches[interest.rule].push_back(cursor);
+                lastRule = interest.rule;
+                ++numMatches;
+            }
+        }
+    };
+
+    CXChildVisitResult dispatchVisitor(CXCursor cursor, CXCursor parent, CXClientData data) {
+        static_cast<DispatchTable *>(data)->dispatch(cursor);
+        return CXChildVisit_Recurse;
+    }
+}
+
+CXDispatchTable clang_DispatchTable_create(unsigned num_rules)
+{
+    DispatchTable *table = new DispatchTable();
+    table->matches.resize(num_rules);
+    return table;
+}
+
+void clang_DispatchTable_addInterest(CXDispatchTable T, unsigned rule,
+                                     enum CXCursorKind kind, int opcode)
+{
+    DispatchTable *table = static_cast<DispatchTable *>(T);
+    if (!table || rule >= table->matches.size())
+        return;
+
+    // Keep interests sorted by rule so that a cursor is recorded at most once
+    // per rule, whatever the number of matching interests.
+    auto &interests = table->interests[kind];
+    auto pos = std::upper_bound(interests.begin(), interests.end(), rule,
+                                [](unsigned r, const DispatchInterest &i) { return r < i.rule; });
+    interests.insert(pos, DispatchInterest{rule, opcode});
+}
+
+unsigned clang_DispatchTable_collect(CXDispatchTable T, CXCursor root)
+{
+    DispatchTable *table = static_cast<DispatchTable *>(T);
+    if (!table)
+        return 0;
+
+    for (std::vector<CXCursor> &matches : table->matches)
+        matches.clear();
+    table->numMatches = 0;
+
+    table->dispatch(root);
+    clang_visitChildren(root, dispatchVisitor, table);
+    return table->numMatches;
+}
+
+unsigned clang_DispatchTable_collectMany(CXDispatchTable T, const CXCursor *roots,
+                                         unsigned num_roots)
+{
+    DispatchTable *table = static_cast<DispatchTable *>(T);
+    if (!table)
+        return 0;
+
+    for (std::vector<CXCursor> &matches : table->matches)
+        matches.clear();
+    table->numMatches = 0;
+
+    for (unsigned i = 0; i < num_roots; ++i) {
+        table->dispatch(roots[i]);
+        clang_visitChildren(roots[i], dispatchVisitor, table);
+    }
+    return table->numMatches;
+}
+
+unsigned clang_DispatchTable_getNumMatches(CXDispatchTable T, unsigned rule)
+{
+    DispatchTable *table = static_cast<DispatchTable *>(T);
+    if (!table || rule >= table->matches.size())
+        return 0;
+    return table->matches[rule].size();
+}
+
+const CXCursor *clang_DispatchTable_getMatches(CXDispatchTable T, unsigned rule)
+{
+    DispatchTable *table = static_cast<DispatchTable *>(T);
+    if (!table || rule >= table->matches.size())
+        return nullptr;
+    return table->matches[rule].data();
+}
+
+void clang_DispatchTable_dispose(CXDispatchTable T)
+{
+    delete static_cast<DispatchTable *>(T);
+}
+
+/************************************************************************
+ * Parent map
+ *
+ * libclang has no parent pointer for statements. ParentMaps are built
+ * lazily, once per function body (or initializer), the first time one of
+ * their statements is asked for its parent.
+ ************************************************************************/
+
+namespace {
+    bool isStmtCursor(CXCursor cursor) {
+        return (cursor.kind >= CXCursor_FirstExpr && cursor.kind <= CXCursor_LastExpr) ||
+               (cursor.kind >= CXCursor_FirstStmt && cursor.kind <= CXCursor_LastStmt);
+    }
+
+    bool isDeclCursor(CXCursor cursor) {
+        return (cursor.kind >= CXCursor_FirstDecl && cursor.kind <= CXCursor_LastDecl) ||
+               (cursor.kind >= CXCursor_FirstExtraDecl && cursor.kind <= CXCursor_LastExtraDecl);
+    }
+
+    /// Statements MakeCXCursor never creates a cursor for (it forwards to a
+    /// child instead).
+    bool isTransparentStmt(const clang::Stmt *S) {
+        if (clang::isa<clang::ConstantExpr>(S) || clang::isa<clang::PseudoObjectExpr>(S))
+            return true;
+        if (const clang::OpaqueValueExpr *OVE = clang::dyn_cast<clang::OpaqueValueExpr>(S))
+            return OVE->getSourceExpr() != nullptr;
+        return false;
+    }
+
+    /// libclang shows condition variables as direct children of the
+    /// statement, without their implicit DeclStmt.
+    bool isConditionDeclStmt(const clang::Stmt *S, const clang::DeclStmt *DS) {
+        if (const clang::IfStmt *If = clang::dyn_cast<clang::IfStmt>(S))
+            return If->getConditionVariableDeclStmt() == DS;
+        if (const clang::SwitchStmt *Switch = clang::dyn_cast<clang::SwitchStmt>(S))
+            return Switch->getConditionVariableDeclStmt() == DS;
+        if (const clang::WhileStmt *While = clang::dyn_cast<clang::WhileStmt>(S))
+            return While->getConditionVariableDeclStmt() == DS;
+        if (const clang::ForStmt *For = clang::dyn_cast<clang::ForStmt>(S))
+            return For->getConditionVariableDeclStmt() == DS;
+        return false;
+    }
+
+    void getDeclRoots(const clang::Decl *D, llvm::SmallVectorImpl<clang::Stmt *> &roots) {
+        if (clang::Stmt *body = D->getBody())
+            roots.push_back(body);
+
+        if (const clang::CXXConstructorDecl *ctor = clang::dyn_cast<clang::CXXConstructorDecl>(D)) {
+            for (const clang::CXXCtorInitializer *init : ctor->inits())
+                if (init->isWritten() && init->getInit())
+                    roots.push_back(init->getInit());
+        } else if (const clang::VarDecl *var = clang::dyn_cast<clang::VarDecl>(D)) {
+            if (var->getInit())
+                roots.push_back(const_cast<clang::Expr *>(var->getInit()));
+        } else if (const clang::FieldDecl *field = clang::dyn_cast<clang::FieldDecl>(D)) {
+            if (field->getInClassInitializer())
+                roots.push_back(field->getInClassInitializer());
+        } else if (const clang::EnumConstantDecl *constant = clang::dyn_cast<clang::EnumConstantDecl>(D)) {
+            if (constant->getInitExpr())
+                roots.push_back(const_cast<clang::Expr *>(constant->getInitExpr()));
+        }
+    }
+
+    struct StmtParents {
+        const clang::Decl *owner;
+        clang::Stmt *root;
+        clang::ParentMap map;
+        llvm::DenseMap<const clang::Decl *, clang::DeclStmt *> declStmts;
+
+        StmtParents(const clang::Decl *owner, clang::Stmt *root)
+            : owner(owner), root(root), map(root) {
+            collectDeclStmts(root);
+        }
+
+        bool contains(const clang::Stmt *S) const {
+            return S == root || map.hasParent(const_cast<clang::Stmt *>(S));
+        }
+
+    private:
+        void collectDeclStmts(clang::Stmt *S) {
+            if (!S)
+                return;
+            if (clang::DeclStmt *DS = clang::dyn_cast<clang::DeclStmt>(S))
+                for (clang::Decl *D : DS->decls())
+                    declStmts[D] = DS;
+            for (clang::Stmt *child : S->children())
+                collectDeclStmts(child);
+        }
+    };
+
+    class ParentMapCache {
+        llvm::DenseMap<const clang::Stmt *, std::unique_ptr<StmtParents>> roots;
+
+        StmtParents *get(const clang::Decl *owner, clang::Stmt *root) {
+            std::unique_ptr<StmtParents> &parents = roots[root];
+            if (!parents)
+                parents.reset(new StmtParents(owner, root));
+            return parents.get();
+        }
+
+        /// Finds the outermost body or initializer, starting from the
+        /// declarations enclosing D, that contains S (or declares local).
+        StmtParents *find(const clang::Decl *D, const clang::Stmt *S, const clang::Decl *local) {
+            llvm::SmallVector<const clang::Decl *, 4> chain;
+            while (D) {
+                chain.push_back(D);
+                const clang::DeclContext *DC = D->getParentFunctionOrMethod();
+                D = DC ? clang::cast<clang::Decl>(DC) : nullptr;
+            }
+
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                llvm::SmallVector<clang::Stmt *, 4> candidates;
+                getDeclRoots(*it, candidates);
+                for (clang::Stmt *root : candidates) {
+                    StmtParents *parents = get(*it, root);
+                    if (S ? parents->contains(S) : parents->declStmts.count(local) != 0)
+                        return parents;
+                }
+            }
+            return nullptr;
+        }
+
+    public:
+        CXCursor getParent(CXCursor cursor) {
+            CXTranslationUnit TU = static_cast<CXTranslationUnit>(const_cast<void *>(cursor.data[2]));
+            const clang::Decl *D = clang::cxcursor::getCursorDecl(cursor);
+
+            if (isStmtCursor(cursor) && D && TU) {
+                const clang::Stmt *S = clang::getCursorStmt(cursor);
+                StmtParents *parents = find(D, S, nullptr);
+                if (!parents)
+                    return clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile);
+
+                clang::Stmt *parent = parents->map.getParent(const_cast<clang::Stmt *>(S));
+                while (parent && isTransparentStmt(parent))
+                    parent = parents->map.getParent(parent);
+                if (!parent)
+                    return clang::cxcursor::MakeCXCursor(parents->owner, TU);
+
+                // Initializers hang below their VarDecl, not the DeclStmt.
+                if (clang::DeclStmt *DS = clang::dyn_cast<clang::DeclStmt>(parent)) {
+                    for (clang::Decl *child : DS->decls()) {
+                        clang::VarDecl *var = clang::dyn_cast<clang::VarDecl>(child);
+                        if (var && var->getInit() == S)
+                            return clang::cxcursor::MakeCXCursor(var, TU);
+                    }
+                }
+                return clang::cxcursor::MakeCXCursor(parent, D, TU);
+            }
+
+            if (isDeclCursor(cursor) && D && TU) {
+                if (const clang::DeclContext *DC = D->getParentFunctionOrMethod()) {
+                    const clang::Decl *function = clang::cast<clang::Decl>(DC);
+                    if (StmtParents *parents = find(function, nullptr, D)) {
+                        clang::Stmt *parent = parents->declStmts.lookup(D);
+                        clang::Stmt *up = parents->map.getParent(parent);
+                        if (up && isConditionDeclStmt(up, clang::cast<clang::DeclStmt>(parent)))
+                            parent = up;
+                        return clang::cxcursor::MakeCXCursor(parent, function, TU);
+                    }
+                }
+
+                const clang::DeclContext *DC = D->getLexicalDeclContext();
+                if (DC && !clang::isa<clang::TranslationUnitDecl>(DC))
+                    return clang::cxcursor::MakeCXCursor(clang::Decl::castFromDeclContext(DC), TU);
+            }
+
+            return clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile);
+        }
+    };
+}
+
+CXParentMap clang_ParentMap_create(void)
+{
+    return new ParentMapCache();
+}
+
+CXCursor clang_ParentMap_getParent(CXParentMap M, CXCursor C)
+{
+    if (!M)
+        return clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile);
+    return static_cast<ParentMapCache *>(M)->getParent(C);
+}
+
+CXCursor clang_ParentMap_getEnclosing(CXParentMap M, CXCursor C, enum CXCursorKind kind)
+{
+    if (!M)
+        return clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile);
+
+    ParentMapCache *cache = static_cast<ParentMapCache *>(M);
+    for (C = cache->getParent(C); C.kind != CXCursor_InvalidFile; C = cache->getParent(C))
+        if (C.kind == kind)
+            return C;
+    return C;
+}
+
+void clang_ParentMap_dispose(CXParentMap M)
+{
+    delete static_cast<ParentMapCache *>(M);
+}
+
+/************************************************************************
+ * Macro index
+ *
+ * Definitions and expansions of the detailed preprocessing record, grouped
+ * by macro, with the argument counts and AST usage of every expansion.
+ ************************************************************************/
+
+namespace {
+    /// Counts the comma separated items of the parenthesized list following
+    /// the macro name at nameLoc. Returns -1 if there is no list; for a macro
+    /// definition the '(' must touch the name and the list ends with the line.
+    /// When isVariadic is given, a trailing unnamed '...' parameter is not
+    /// counted.
+    int countMacroListItems(const clang::SourceManager &SM, const clang::LangOptions &LangOpts,
+                            clang::SourceLocation nameLoc, bool isDefinition, bool *isVariadic)
+    {
+        std::pair<clang::FileID, unsigned> decomposed = SM.getDecomposedLoc(nameLoc);
+        bool invalid = false;
+        llvm::StringRef buffer = SM.getBufferData(decomposed.first, &invalid);
+        if (invalid)
+            return -1;
+
+        clang::Lexer lexer(SM.getLocForStartOfFile(decomposed.first), LangOpts,
+                           buffer.begin(), buffer.begin() + decomposed.second, buffer.end());
+        clang::Token tok;
+        lexer.LexFromRawLexer(tok);
+        lexer.LexFromRawLexer(tok);
+        if (!tok.is(clang::tok::l_paren) || (isDefinition && tok.hasLeadingSpace()))
+            return -1;
+
+        int depth = 0;
+        int commas = 0;
+        bool empty = true;
+        // Tokens of the current item, and whether it is a lone '...'.
+        unsigned itemTokens = 0;
+        bool unnamedEllipsis = false;
+        while (true) {
+            lexer.LexFromRawLexer(tok);
+            if (tok.is(clang::tok::eof) || (isDefinition && tok.isAtStartOfLine()))
+                break;
+
+            if (tok.is(clang::tok::r_paren)) {
+                if (depth == 0)
+                    break;
+                --depth;
+            } else if (tok.is(clang::tok::l_paren)) {
+                ++depth;
+            } else if (tok.is(clang::tok::comma) && depth == 0) {
+                ++commas;
+                itemTokens = 0;
+                empty = false;
+                continue;
+            } else if (tok.is(clang::tok::ellipsis) && isVariadic) {
+                *isVariadic = true;
+                unnamedEllipsis = itemTokens == 0;
+            }
+            ++itemTokens;
+            empty = false;
+        }
+        if (empty)
+            return 0;
+        return unnamedEllipsis && itemTokens == 1 ? commas : commas + 1;
+    }
+
+    /// Records the file-level expansions each macro-generated AST location
+    /// comes from. Tokens of a macro argument also belong to the expansions
+    /// they were spelled in, e.g. SQUARE in LOG(SQUARE(a)).
+    class MacroUseCollector : public clang::RecursiveASTVisitor<MacroUseCollector> {
+        const clang::SourceManager &SM;
+        llvm::DenseSet<unsigned> &expansions;
+
+        void note(clang::SourceLocation loc) {
+            if (!loc.isMacroID())
+                return;
+
+            while (loc.isMacroID()) {
+                if (SM.isMacroArgExpansion(loc))
+                    note(SM.getImmediateSpellingLoc(loc));
+                loc = SM.getImmediateExpansionRange(loc).getBegin();
+            }
+            expansions.insert(loc.getRawEncoding());
+        }
+
+    public:
+        MacroUseCollector(const clang::SourceManager &SM, llvm::DenseSet<unsigned> &expansions)
+            : SM(SM), expansions(expansions) {}
+
+        bool VisitDecl(clang::Decl *D) {
+            note(D->getLocation());
+            note(D->getBeginLoc());
+            return true;
+        }
+
+        bool VisitStmt(clang::Stmt *S) {
+            note(S->getBeginLoc());
+            note(S->getEndLoc());
+            return true;
+        }
+
+        bool VisitTypeLoc(clang::TypeLoc TL) {
+            note(TL.getBeginLoc());
+            return true;
+        }
+    };
+
+    struct MacroIndex {
+        std::vector<std::string> files;
+        llvm::StringMap<unsigned> fileIds;
+        std::vector<std::string> names;
+        std::vector<CXMacroDefinitionInfo> definitions;
+        std::vector<CXMacroExpansionInfo> expansions;
+
+        void setPosition(const clang::SourceManager &SM, clang::SourceLocation loc,
+                         unsigned &file, unsigned &line, unsigned &column, unsigned &offset) {
+            loc = SM.getExpansionLoc(loc);
+            llvm::StringRef name = SM.getBufferName(loc);
+            auto inserted = fileIds.try_emplace(name, files.size());
+            if (inserted.second)
+                files.push_back(name.str());
+
+            file = inserted.first->second;
+            line = SM.getSpellingLineNumber(loc);
+            column = SM.getSpellingColumnNumber(loc);
+            offset = SM.getFileOffset(loc);
+        }
+    };
+}
+
+CXMacroIndex clang_TranslationUnit_getMacroIndex(CXTranslationUnit TU)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    clang::PreprocessingRecord *record = unit->getPreprocessor().getPreprocessingRecord();
+    if (!record)
+        return nullptr;
+
+    const clang::SourceManager &SM = unit->getSourceManager();
+    const clang::LangOptions &LangOpts = unit->getLangOpts();
+
+    llvm::DenseSet<unsigned> used;
+    MacroUseCollector(SM, used).TraverseDecl(unit->getASTContext().getTranslationUnitDecl());
+
+    // Collect definitions and expansions in record order, then group them.
+    struct Definition {
+        std::string name;
+        CXMacroDefinitionInfo info;
+    };
+    std::vector<Definition> definitions;
+    llvm::DenseMap<const clang::MacroDefinitionRecord *, unsigned> definitionIds;
+    llvm::StringMap<unsigned> builtinIds;
+    std::vector<CXMacroExpansionInfo> expansions;
+    MacroIndex *index = new MacroIndex();
+
+    for (clang::PreprocessedEntity *entity : *record) {
+        if (!entity)
+            continue;
+
+        if (clang::MacroDefinitionRecord *def = clang::dyn_cast<clang::MacroDefinitionRecord>(entity)) {
+            Definition definition;
+            definition.name = def->getName()->getName().str();
+            definition.info = CXMacroDefinitionInfo();
+            index->setPosition(SM, def->getLocation(), definition.info.file, definition.info.line,
+                               definition.info.column, definition.info.offset);
+
+            bool variadic = false;
+            definition.info.num_params =
+                countMacroListItems(SM, LangOpts, def->getLocation(), true, &variadic);
+            definition.info.is_variadic = variadic;
+
+            definitionIds[def] = definitions.size();
+            definitions.push_back(definition);
+            continue;
+        }
+
+        clang::MacroExpansion *expansion = clang::dyn_cast<clang::MacroExpansion>(entity);
+        if (!expansion)
+            continue;
+
+        CXMacroExpansionInfo info = CXMacroExpansionInfo();
+        if (clang::MacroDefinitionRecord *def = expansion->getDefinition()) {
+            // The definition may be an entity the record did not hand out,
+            // e.g. one of a loaded preamble.
+            auto it = definitionIds.find(def);
+            info.definition = it != definitionIds.end() ? static_cast<int>(it->second) : -1;
+        } else {
+            // Builtin macros have no definition record; give them one.
+            llvm::StringRef name = expansion->getName()->getName();
+            auto inserted = builtinIds.try_emplace(name, definitions.size());
+            if (inserted.second) {
+                Definition definition;
+                definition.name = name.str();
+                definition.info = CXMacroDefinitionInfo();
+                definition.info.file = ~0U;
+                definition.info.num_params = -1;
+                definitions.push_back(definition);
+            }
+            info.definition = inserted.first->second;
+        }
+
+        clang::SourceLocation loc = expansion->getSourceRange().getBegin();
+        index->setPosition(SM, loc, info.file, info.line, info.column, info.offset);
+        if (info.definition < 0 || definitions[info.definition].info.num_params >= 0)
+            info.num_args = countMacroListItems(SM, LangOpts, loc, false, nullptr);
+        else
+            info.num_args = -1;
+        info.produced_ast = used.count(SM.getExpansionLoc(loc).getRawEncoding()) != 0;
+        expansions.push_back(info);
+    }
+
+    std::vector<unsigned> order(definitions.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return definitions[a].name < definitions[b].name;
+    });
+
+    std::vector<unsigned> position(definitions.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        position[order[i]] = i;
+
+    for (CXMacroExpansionInfo &info : expansions) {
+        if (info.definition < 0)
+            continue;
+        info.definition = position[info.definition];
+        ++definitions[order[info.definition]].info.num_expansions;
+    }
+    // Expansions of unknown definitions go last.
+    std::stable_sort(expansions.begin(), expansions.end(),
+                     [](const CXMacroExpansionInfo &a, const CXMacroExpansionInfo &b) {
+                         return static_cast<unsigned>(a.definition) < static_cast<unsigned>(b.definition);
+                     });
+
+    unsigned first = 0;
+    for (unsigned i : order) {
+        definitions[i].info.first_expansion = first;
+        first += definitions[i].info.num_expansions;
+        index->names.push_back(definitions[i].name);
+        index->definitions.push_back(definitions[i].info);
+    }
+    index->expansions = std::move(expansions);
+    return index;
+}
+
+unsigned clang_MacroIndex_getNumFiles(CXMacroIndex I)
+{
+    return I ? static_cast<MacroIndex *>(I)->files.size() : 0;
+}
+
+CXString clang_MacroIndex_getFileName(CXMacroIndex I, unsigned index)
+{
+    MacroIndex *macros = static_cast<MacroIndex *>(I);
+    if (!macros || index >= macros->files.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(macros->files[index]);
+}
+
+unsigned clang_MacroIndex_getNumDefinitions(CXMacroIndex I)
+{
+    return I ? static_cast<MacroIndex *>(I)->definitions.size() : 0;
+}
+
+CXString clang_MacroIndex_getDefinitionName(CXMacroIndex I, unsigned index)
+{
+    MacroIndex *macros = static_cast<MacroIndex *>(I);
+    if (!macros || index >= macros->names.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(macros->names[index]);
+}
+
+const CXMacroDefinitionInfo *clang_MacroIndex_getDefinitions(CXMacroIndex I)
+{
+    return I ? static_cast<MacroIndex *>(I)->definitions.data() : nullptr;
+}
+
+int clang_MacroIndex_findDefinition(CXMacroIndex I, const char *name)
+{
+    MacroIndex *macros = static_cast<MacroIndex *>(I);
+    if (!macros || !name)
+        return -1;
+
+    auto it = std::lower_bound(macros->names.begin(), macros->names.end(), name);
+    if (it == macros->names.end() || *it != name)
+        return -1;
+    return it - macros->names.begin();
+}
+
+unsigned clang_MacroIndex_getNumExpansions(CXMacroIndex I)
+{
+    return I ? static_cast<MacroIndex *>(I)->expansions.size() : 0;
+}
+
+const CXMacroExpansionInfo *clang_MacroIndex_getExpansions(CXMacroIndex I)
+{
+    return I ? static_cast<MacroIndex *>(I)->expansions.data() : nullptr;
+}
+
+void clang_MacroIndex_dispose(CXMacroIndex I)
+{
+    delete static_cast<MacroIndex *>(I);
+}
+
+/************************************************************************
+ * Rewriting
+ *
+ * Batches of (range, replacement) edits applied with clang's Rewriter in a
+ * single pass over every modified file.
+ ************************************************************************/
+
+namespace {
+    struct RewriteEdit {
+        clang::FileID file;
+        unsigned begin;
+        unsigned end;
+        std::string text;
+        bool valid;
+    };
+
+    struct RewriteBatch {
+        clang::ASTUnit *unit;
+        std::vector<RewriteEdit> edits;
+        std::vector<CXRewriteRejection> rejections;
+        std::vector<std::string> names;
+        std::vector<std::string> buffers;
+
+        void add(clang::CharSourceRange range, llvm::StringRef text) {
+            const clang::SourceManager &SM = unit->getSourceManager();
+            RewriteEdit edit;
+            edit.text = text.str();
+            edit.valid = false;
+
+            clang::SourceLocation begin = range.getBegin();
+            clang::SourceLocation end = range.getEnd();
+            if (begin.isValid() && end.isValid() && begin.isFileID() && end.isFileID()) {
+                if (range.isTokenRange())
+                    end = end.getLocWithOffset(
+                        clang::Lexer::MeasureTokenLength(end, SM, unit->getLangOpts()));
+
+                std::pair<clang::FileID, unsigned> b = SM.getDecomposedLoc(begin);
+                std::pair<clang::FileID, unsigned> e = SM.getDecomposedLoc(end);
+                edit.file = b.first;
+                edit.begin = b.second;
+                edit.end = e.second;
+                edit.valid = b.first == e.first && b.second <= e.second;
+
+                // A header included several times has one FileID per
+                // inclusion; edit all of them through the first one so that
+                // the file gets a single rewritten buffer.
+                if (const clang::FileEntry *entry = SM.getFileEntryForID(edit.file)) {
+                    clang::FileID first = SM.translateFile(entry);
+                    if (first.isValid())
+                        edit.file = first;
+                }
+            }
+            edits.push_back(edit);
+        }
+    };
+
+    bool isSameEdit(const RewriteEdit &a, const RewriteEdit &b)
+    {
+        return a.begin == b.begin && a.end == b.end && a.text == b.text;
+    }
+
+    /// The edits accepted in one file. Replacements overlap when they share
+    /// a character; an insertion overlaps a replacement when it lies
+    /// strictly inside it. Insertions at the same location and edits that
+    /// merely touch do not overlap, so replacements stay disjoint and sorted
+    /// by both begin and end.
+    class AcceptedEdits {
+    public:
+        enum Result { Accepted, Duplicate, Overlap };
+
+        Result add(const std::vector<RewriteEdit> &edits, unsigned index) {
+            const RewriteEdit &edit = edits[index];
+            if (edit.begin == edit.end) {
+                for (auto it = insertions.lower_bound(edit.begin);
+                     it != insertions.end() && it->first == edit.begin; ++it)
+                    if (isSameEdit(edits[it->second], edit))
+                        return Duplicate;
+                // The last replacement starting before the insertion.
+                auto it = replacements.lower_bound(edit.begin);
+                if (it != replacements.begin() && edits[std::prev(it)->second].end > edit.begin)
+                    return Overlap;
+                insertions.emplace(edit.begin, index);
+                return Accepted;
+            }
+
+            // The last replacement starting before the end of the edit.
+            auto it = replacements.lower_bound(edit.end);
+            if (it != replacements.begin()) {
+                const RewriteEdit &other = edits[std::prev(it)->second];
+                if (isSameEdit(other, edit))
+                    return Duplicate;
+                if (other.end > edit.begin)
+                    return Overlap;
+            }
+            auto inside = insertions.upper_bound(edit.begin);
+            if (inside != insertions.end() && inside->first < edit.end)
+                return Overlap;
+            replacements.emplace(edit.begin, index);
+            return Accepted;
+        }
+
+    private:
+        std::map<unsigned, unsigned> replacements;
+        std::multimap<unsigned, unsigned> insertions;
+    };
+}
+
+CXRewriteBatch clang_RewriteBatch_create(CXTranslationUnit TU)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    RewriteBatch *batch = new RewriteBatch();
+    batch->unit = unit;
+    return batch;
+}
+
+void clang_RewriteBatch_addEdits(CXRewriteBatch B, const CXSourceRange *ranges,
+                                 const char *const *texts, unsigned num_edits)
+{
+    RewriteBatch *batch = static_cast<RewriteBatch *>(B);
+    if (!batch)
+        return;
+
+    const clang::SourceManager &SM = batch->unit->getSourceManager();
+    for (unsigned i = 0; i < num_edits; ++i) {
+        // Same as cxloc::translateCXSourceRange; ranges of another
+        // translation unit are invalid here.
+        clang::CharSourceRange range = clang::CharSourceRange::getCharRange(
+            clang::SourceLocation::getFromRawEncoding(ranges[i].begin_int_data),
+            clang::SourceLocation::getFromRawEncoding(ranges[i].end_int_data));
+        if (ranges[i].ptr_data[0] != &SM)
+            range = clang::CharSourceRange();
+        batch->add(range, texts[i] ? texts[i] : "");
+    }
+}
+
+unsigned clang_RewriteBatch_addFixIts(CXRewriteBatch B)
+{
+    RewriteBatch *batch = static_cast<RewriteBatch *>(B);
+    if (!batch)
+        return 0;
+
+    const clang::SourceManager &SM = batch->unit->getSourceManager();
+    unsigned count = 0;
+    for (auto it = batch->unit->stored_diag_begin(); it != batch->unit->stored_diag_end(); ++it) {
+        if (it->getLevel() < clang::DiagnosticsEngine::Warning)
+            continue;
+
+        for (const clang::FixItHint &hint : it->getFixIts()) {
+            std::string text = hint.CodeToInsert;
+            if (hint.InsertFromRange.isValid())
+                text = clang::Lexer::getSourceText(hint.InsertFromRange, SM,
+                                                   batch->unit->getLangOpts()).str();
+            batch->add(hint.RemoveRange, text);
+            ++count;
+        }
+    }
+    return count;
+}
+
+unsigned clang_RewriteBatch_apply(CXRewriteBatch B)
+{
+    RewriteBatch *batch = static_cast<RewriteBatch *>(B);
+    if (!batch)
+        return 0;
+
+    batch->rejections.clear();
+    batch->names.clear();
+    batch->buffers.clear();
+
+    // Accept edits in submission order.
+    std::map<clang::FileID, AcceptedEdits> accepted;
+    std::vector<unsigned> order;
+    for (unsigned i = 0; i < batch->edits.size(); ++i) {
+        const RewriteEdit &edit = batch->edits[i];
+        if (!edit.valid) {
+            batch->rejections.push_back({i, CXRewriteRejection_InvalidRange});
+            continue;
+        }
+
+        switch (accepted[edit.file].add(batch->edits, i)) {
+        case AcceptedEdits::Accepted:
+            order.push_back(i);
+            break;
+        case AcceptedEdits::Duplicate:
+            break;
+        case AcceptedEdits::Overlap:
+            batch->rejections.push_back({i, CXRewriteRejection_Overlap});
+            break;
+        }
+    }
+
+    const clang::SourceManager &SM = batch->unit->getSourceManager();
+    clang::Rewriter rewriter(const_cast<clang::SourceManager &>(SM), batch->unit->getLangOpts());
+    for (unsigned i : order) {
+        const RewriteEdit &edit = batch->edits[i];
+        clang::SourceLocation loc = SM.getLocForStartOfFile(edit.file).getLocWithOffset(edit.begin);
+        if (edit.begin == edit.end)
+            rewriter.InsertText(loc, edit.text, true);
+        else
+            rewriter.ReplaceText(loc, edit.end - edit.begin, edit.text);
+    }
+
+    for (auto it = rewriter.buffer_begin(); it != rewriter.buffer_end(); ++it) {
+        std::string contents;
+        llvm::raw_string_ostream os(contents);
+        it->second.write(os);
+        os.flush();
+
+        const clang::FileEntry *entry = SM.getFileEntryForID(it->first);
+        batch->names.push_back(entry ? entry->getName().str() : SM.getBufferName(SM.getLocForStartOfFile(it->first)).str());
+        batch->buffers.push_back(std::move(contents));
+    }
+
+    return batch->rejections.size();
+}
+
+const CXRewriteRejection *clang_RewriteBatch_getRejections(CXRewriteBatch B)
+{
+    return B ? static_cast<RewriteBatch *>(B)->rejections.data() : nullptr;
+}
+
+unsigned clang_RewriteBatch_getNumFiles(CXRewriteBatch B)
+{
+    return B ? static_cast<RewriteBatch *>(B)->names.size() : 0;
+}
+
+CXString clang_RewriteBatch_getFileName(CXRewriteBatch B, unsigned index)
+{
+    RewriteBatch *batch = static_cast<RewriteBatch *>(B);
+    if (!batch || index >= batch->names.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(batch->names[index]);
+}
+
+const char *clang_RewriteBatch_getBuffer(CXRewriteBatch B, unsigned index, unsigned *length)
+{
+    RewriteBatch *batch = static_cast<RewriteBatch *>(B);
+    if (!batch || index >= batch->buffers.size()) {
+        if (length)
+            *length = 0;
+        return nullptr;
+    }
+
+    if (length)
+        *length = batch->buffers[index].size();
+    return batch->buffers[index].data();
+}
+
+void clang_RewriteBatch_dispose(CXRewriteBatch B)
+{
+    delete static_cast<RewriteBatch *>(B);
+}
+
+/************************************************************************
+ * Structural hashing
+ *
+ * Bottom-up hashes of statement subtrees for clone detection. Hashes are
+ * computed with a fixed mixing function, so they are stable across
+ * processes and can be merged across translation units.
+ ************************************************************************/
+
+namespace {
+    uint64_t hashMix(uint64_t h, uint64_t v)
+    {
+        v *= 0x87c37b91114253d5ULL;
+        v = (v << 31) | (v >> 33);
+        v *= 0x4cf5ad432745937fULL;
+        h ^= v;
+        h = (h << 27) | (h >> 37);
+        return h * 5 + 0x52dce729;
+    }
+
+    /// Implicit nodes that do not show in the source are hashed through.
+    const clang::Stmt *skipImplicit(const clang::Stmt *S)
+    {
+        while (S) {
+            const clang::Stmt *next = S;
+            if (const clang::Expr *E = clang::dyn_cast<clang::Expr>(S))
+                next = E->IgnoreImplicit();
+            if (const clang::PseudoObjectExpr *POE = clang::dyn_cast<clang::PseudoObjectExpr>(next))
+                next = POE->getSyntacticForm();
+            else if (const clang::OpaqueValueExpr *OVE = clang::dyn_cast<clang::OpaqueValueExpr>(next))
+                next = OVE->getSourceExpr() ? OVE->getSourceExpr() : next;
+            if (next == S)
+                break;
+            S = next;
+        }
+        return S;
+    }
+
+    struct SubtreeHashes {
+        CXTranslationUnit TU;
+        std::vector<std::string> files;
+        llvm::DenseMap<clang::FileID, unsigned> fileIds;
+        std::vector<CXSubtreeHash> records;
+        std::vector<std::pair<const clang::Stmt *, const clang::Decl *>> stmts;
+    };
+
+    class SubtreeHasher {
+    public:
+        SubtreeHasher(const clang::SourceManager &SM, unsigned options)
+            : SM(SM), options(options) {}
+
+        /// Hashes S; when records is set, subtrees of at least minSize
+        /// nodes are recorded in preorder.
+        std::pair<uint64_t, unsigned> hash(const clang::Stmt *S, const clang::Decl *parent) {
+            S = skipImplicit(S);
+            if (!S)
+                return {0, 0};
+
+            unsigned slot = 0;
+            if (records) {
+                slot = records->records.size();
+                records->records.emplace_back();
+                records->stmts.emplace_back(S, parent);
+            }
+
+            uint64_t h = hashMix(0, S->getStmtClass());
+            h = hashNode(h, S);
+
+            unsigned size = 1;
+            for (const clang::Stmt *child : S->children()) {
+                std::pair<uint64_t, unsigned> sub = hash(child, parent);
+                h = hashMix(h, sub.first);
+                size += sub.second;
+            }
+
+            if (records) {
+                if (size >= minSize)
+                    record(slot, S, parent, h, size);
+                else {
+                    // Children are recorded after slot and are smaller.
+                    records->records.resize(slot);
+                    records->stmts.resize(slot);
+                }
+            }
+            return {h, size};
+        }
+
+        SubtreeHashes *records = nullptr;
+        unsigned minSize = 1;
+
+    private:
+        uint64_t hashName(uint64_t h, const clang::NamedDecl *D) {
+            if (!(options & CXStructuralHash_Identifiers) || !D || !D->getDeclName())
+                return h;
+            return hashMix(h, llvm::xxHash64(D->getDeclName().getAsString()));
+        }
+
+        uint64_t hashNode(uint64_t h, const clang::Stmt *S) {
+            if (const clang::BinaryOperator *op = clang::dyn_cast<clang::BinaryOperator>(S))
+                return hashMix(h, op->getOpcode());
+            if (const clang::UnaryOperator *op = clang::dyn_cast<clang::UnaryOperator>(S))
+                return hashMix(h, op->getOpcode());
+            if (const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(S))
+                return hashName(h, ref->getDecl());
+            if (const clang::MemberExpr *member = clang::dyn_cast<clang::MemberExpr>(S))
+                return hashMix(hashName(h, member->getMemberDecl()), member->isArrow());
+            if (const clang::DeclStmt *DS = clang::dyn_cast<clang::DeclStmt>(S)) {
+                for (const clang::Decl *D : DS->decls())
+                    h = hashName(hashMix(h, D->getKind()), clang::dyn_cast<clang::NamedDecl>(D));
+                return h;
+            }
+            if (const clang::UnaryExprOrTypeTraitExpr *trait = clang::dyn_cast<clang::UnaryExprOrTypeTraitExpr>(S))
+                return hashMix(h, trait->getKind());
+
+            if (!(options & CXStructuralHash_Literals))
+                return h;
+
+            if (const clang::IntegerLiteral *literal = clang::dyn_cast<clang::IntegerLiteral>(S))
+                return hashMix(h, literal->getValue().getLimitedValue());
+            if (const clang::CharacterLiteral *literal = clang::dyn_cast<clang::CharacterLiteral>(S))
+                return hashMix(h, literal->getValue());
+            if (const clang::FloatingLiteral *literal = clang::dyn_cast<clang::FloatingLiteral>(S))
+                return hashMix(h, literal->getValue().bitcastToAPInt().getLimitedValue());
+            if (const clang::StringLiteral *literal = clang::dyn_cast<clang::StringLiteral>(S))
+                return hashMix(h, llvm::xxHash64(literal->getBytes()));
+            if (const clang::CXXBoolLiteralExpr *literal = clang::dyn_cast<clang::CXXBoolLiteralExpr>(S))
+                return hashMix(h, literal->getValue());
+            return h;
+        }
+
+        void record(unsigned slot, const clang::Stmt *S, const clang::Decl *parent,
+                    uint64_t h, unsigned size) {
+            CXSubtreeHash &info = records->records[slot];
+            info.hash = h;
+            info.size = size;
+            info.kind = clang::cxcursor::MakeCXCursor(S, parent, records->TU).kind;
+
+            clang::SourceLocation loc = SM.getExpansionLoc(S->getBeginLoc());
+            std::pair<clang::FileID, unsigned> decomposed = SM.getDecomposedLoc(loc);
+            auto inserted = records->fileIds.try_emplace(decomposed.first, records->files.size());
+            if (inserted.second)
+                records->files.push_back(SM.getBufferName(loc).str());
+
+            info.file = inserted.first->second;
+            info.line = SM.getSpellingLineNumber(loc);
+            info.column = SM.getSpellingColumnNumber(loc);
+            info.offset = decomposed.second;
+        }
+
+        const clang::SourceManager &SM;
+        unsigned options;
+    };
+
+    /// The code body of a function, method or block declaration, if any.
+    const clang::Stmt *getCodeBody(const clang::Decl *D)
+    {
+        if (!clang::isa<clang::FunctionDecl>(D) && !clang::isa<clang::ObjCMethodDecl>(D) &&
+            !clang::isa<clang::BlockDecl>(D))
+            return nullptr;
+        return D->getBody();
+    }
+
+    /// Calls back once per code body of a declaration tree, with the
+    /// declaration owning the body.
+    class BodyCollector : public clang::RecursiveASTVisitor<BodyCollector> {
+    public:
+        typedef llvm::function_ref<void(const clang::Stmt *, const clang::Decl *)> Callback;
+
+        BodyCollector(const clang::SourceManager &SM, bool mainFileOnly, Callback callback)
+            : SM(SM), mainFileOnly(mainFileOnly), callback(callback) {}
+
+        bool VisitDecl(clang::Decl *D) {
+            if (D->isImplicit())
+                return true;
+            // Lambda bodies are part of the enclosing body.
+            if (const clang::CXXMethodDecl *method = clang::dyn_cast<clang::CXXMethodDecl>(D))
+                if (method->getParent()->isLambda())
+                    return true;
+            if (mainFileOnly && !SM.isInMainFile(SM.getExpansionLoc(D->getLocation())))
+                return true;
+
+            // Only the defining declaration has the body.
+            const clang::Stmt *body = getCodeBody(D);
+            if (body && (!clang::isa<clang::FunctionDecl>(D) ||
+                         clang::cast<clang::FunctionDecl>(D)->doesThisDeclarationHaveABody()))
+                callback(body, D);
+            return true;
+        }
+
+    private:
+        const clang::SourceManager &SM;
+        bool mainFileOnly;
+        Callback callback;
+    };
+
+    struct CloneIndex {
+        std::vector<std::string> files;
+        llvm::StringMap<unsigned> fileIds;
+        std::vector<CXSubtreeHash> records;
+        std::vector<CXCloneBucket> buckets;
+    };
+}
+
+unsigned long long clang_Cursor_getStructuralHash(CXCursor C, unsigned options, unsigned *size)
+{
+    const clang::Stmt *S = nullptr;
+    const clang::Decl *parent = nullptr;
+    if (isStmtCursor(C)) {
+        S = clang::getCursorStmt(C);
+        parent = static_cast<const clang::Decl *>(C.data[0]);
+    } else if (isDeclCursor(C)) {
+        parent = clang::cxcursor::getCursorDecl(C);
+        S = parent ? getCodeBody(parent) : nullptr;
+    }
+
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(static_cast<CXTranslationUnit>(const_cast<void *>(C.data[2])));
+    if (!S || !unit) {
+        if (size)
+            *size = 0;
+        return 0;
+    }
+
+    std::pair<uint64_t, unsigned> result = SubtreeHasher(unit->getSourceManager(), options).hash(S, parent);
+    if (size)
+        *size = result.second;
+    return result.first;
+}
+
+CXSubtreeHashes clang_TranslationUnit_getSubtreeHashes(CXTranslationUnit TU, unsigned options,
+                                                       unsigned min_size)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    SubtreeHashes *hashes = new SubtreeHashes();
+    hashes->TU = TU;
+
+    SubtreeHasher hasher(unit->getSourceManager(), options);
+    hasher.records = hashes;
+    hasher.minSize = std::max(min_size, 1U);
+    BodyCollector(unit->getSourceManager(), options & CXStructuralHash_MainFileOnly,
+                  [&](const clang::Stmt *body, const clang::Decl *D) { hasher.hash(body, D); })
+        .TraverseDecl(unit->getASTContext().getTranslationUnitDecl());
+    return hashes;
+}
+
+unsigned clang_SubtreeHashes_getNumFiles(CXSubtreeHashes H)
+{
+    return H ? static_cast<SubtreeHashes *>(H)->files.size() : 0;
+}
+
+CXString clang_SubtreeHashes_getFileName(CXSubtreeHashes H, unsigned index)
+{
+    SubtreeHashes *hashes = static_cast<SubtreeHashes *>(H);
+    if (!hashes || index >= hashes->files.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(hashes->files[index]);
+}
+
+unsigned clang_SubtreeHashes_getNumRecords(CXSubtreeHashes H)
+{
+    return H ? static_cast<SubtreeHashes *>(H)->records.size() : 0;
+}
+
+const CXSubtreeHash *clang_SubtreeHashes_getRecords(CXSubtreeHashes H)
+{
+    return H ? static_cast<SubtreeHashes *>(H)->records.data() : nullptr;
+}
+
+CXCursor clang_SubtreeHashes_getCursor(CXSubtreeHashes H, unsigned index)
+{
+    SubtreeHashes *hashes = static_cast<SubtreeHashes *>(H);
+    if (!hashes || index >= hashes->stmts.size())
+        return clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile);
+
+    return clang::cxcursor::MakeCXCursor(hashes->stmts[index].first, hashes->stmts[index].second,
+                                         hashes->TU);
+}
+
+void clang_SubtreeHashes_dispose(CXSubtreeHashes H)
+{
+    delete static_cast<SubtreeHashes *>(H);
+}
+
+CXCloneIndex clang_CloneIndex_create(void)
+{
+    return new CloneIndex();
+}
+
+void clang_CloneIndex_add(CXCloneIndex I, CXSubtreeHashes H)
+{
+    CloneIndex *index = static_cast<CloneIndex *>(I);
+    SubtreeHashes *hashes = static_cast<SubtreeHashes *>(H);
+    if (!index || !hashes)
+        return;
+
+    std::vector<unsigned> fileIds;
+    for (const std::string &name : hashes->files) {
+        auto inserted = index->fileIds.try_emplace(name, index->files.size());
+        if (inserted.second)
+            index->files.push_back(name);
+        fileIds.push_back(inserted.first->second);
+    }
+
+    for (CXSubtreeHash record : hashes->records) {
+        record.file = fileIds[record.file];
+        index->records.push_back(record);
+    }
+}
+
+unsigned clang_CloneIndex_getNumFiles(CXCloneIndex I)
+{
+    return I ? static_cast<CloneIndex *>(I)->files.size() : 0;
+}
+
+CXString clang_CloneIndex_getFileName(CXCloneIndex I, unsigned index)
+{
+    CloneIndex *clones = static_cast<CloneIndex *>(I);
+    if (!clones || index >= clones->files.size())
+        return clang::cxstring::createEmpty();
+    return clang::cxstring::createDup(clones->files[index]);
+}
+
+unsigned clang_CloneIndex_computeBuckets(CXCloneIndex I, unsigned min_count)
+{
+    CloneIndex *index = static_cast<CloneIndex *>(I);
+    if (!index)
+        return 0;
+
+    // Sort by hash, then position, and drop subtrees merged more than once
+    // (headers shared by several translation units).
+    std::vector<CXSubtreeHash> &records = index->records;
+    auto key = [](const CXSubtreeHash &r) {
+        return std::make_tuple(r.hash, r.file, r.offset, r.kind, r.size);
+    };
+    std::sort(records.begin(), records.end(),
+              [&](const CXSubtreeHash &a, const CXSubtreeHash &b) { return key(a) < key(b); });
+    records.erase(std::unique(records.begin(), records.end(),
+                              [&](const CXSubtreeHash &a, const CXSubtreeHash &b) { return key(a) == key(b); }),
+                  records.end());
+
+    index->buckets.clear();
+    for (unsigned first = 0; first < records.size();) {
+        unsigned last = first + 1;
+        while (last < records.size() && records[last].hash == records[first].hash)
+            ++last;
+        if (last - first >= std::max(min_count, 1U))
+            index->buckets.push_back({records[first].hash, first, last - first});
+        first = last;
+    }
+    return index->buckets.size();
+}
+
+const CXCloneBucket *clang_CloneIndex_getBuckets(CXCloneIndex I)
+{
+    return I ? static_cast<CloneIndex *>(I)->buckets.data() : nullptr;
+}
+
+const CXSubtreeHash *clang_CloneIndex_getRecords(CXCloneIndex I)
+{
+    return I ? static_cast<CloneIndex *>(I)->records.data() : nullptr;
+}
+
+unsigned clang_CloneIndex_getNumRecords(CXCloneIndex I)
+{
+    return I ? static_cast<CloneIndex *>(I)->records.size() : 0;
+}
+
+void clang_CloneIndex_dispose(CXCloneIndex I)
+{
+    delete static_cast<CloneIndex *>(I);
+}
+
+/************************************************************************
+ * Source printing
+ *
+ * clang's Stmt/Decl printers applied to cursors, one at a time or in bulk.
+ ************************************************************************/
+
+namespace {
+    /// Prints references to non-local declarations by qualified name.
+    class QualifyingPrinterHelper : public clang::PrinterHelper {
+    public:
+        bool handledStmt(clang::Stmt *S, llvm::raw_ostream &os) override {
+            const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(S);
+            if (!ref || ref->hasExplicitTemplateArgs())
+                return false;
+
+            const clang::ValueDecl *D = ref->getDecl();
+            if (D->getDeclContext()->isFunctionOrMethod() || clang::isa<clang::ParmVarDecl>(D) ||
+                !D->getDeclName().isIdentifier())
+                return false;
+
+            os << D->getQualifiedNameAsString();
+            return true;
+        }
+    };
+
+    /// Collapses whitespace runs outside of string and character literals
+    /// to single spaces.
+    std::string compactSource(llvm::StringRef text)
+    {
+        std::string result;
+        result.reserve(text.size());
+        char quote = 0;
+        bool space = false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (quote) {
+                result += c;
+                if (c == '\\' && i + 1 < text.size())
+                    result += text[++i];
+                else if (c == quote)
+                    quote = 0;
+                continue;
+            }
+
+            if (clang::isWhitespace(c)) {
+                space = true;
+                continue;
+            }
+            if (space && !result.empty())
+                result += ' ';
+            space = false;
+
+            if (c == '"' || c == '\'')
+                quote = c;
+            result += c;
+        }
+        return result;
+    }
+
+    void printCursor(CXCursor C, unsigned options, std::string &out)
+    {
+        CXTranslationUnit TU = static_cast<CXTranslationUnit>(const_cast<void *>(C.data[2]));
+        clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+        if (!unit)
+            return;
+
+        clang::ASTContext &context = unit->getASTContext();
+        clang::PrintingPolicy policy = context.getPrintingPolicy();
+        if (options & CXPrintSource_FullyQualified) {
+            policy.FullyQualifiedName = true;
+            policy.PrintCanonicalTypes = true;
+            policy.SuppressScope = false;
+        }
+        if (options & CXPrintSource_Terse)
+            policy.TerseOutput = true;
+
+        std::string text;
+        llvm::raw_string_ostream os(text);
+        if (isStmtCursor(C)) {
+            QualifyingPrinterHelper helper;
+            clang::PrinterHelper *printerHelper =
+                options & CXPrintSource_FullyQualified ? &helper : nullptr;
+            if (const clang::Stmt *S = clang::getCursorStmt(C))
+                S->printPretty(os, printerHelper, policy, 0, "\n", &context);
+        } else if (isDeclCursor(C)) {
+            if (const clang::Decl *D = clang::cxcursor::getCursorDecl(C))
+                D->print(os, policy);
+        }
+        os.flush();
+
+        if (options & CXPrintSource_Compact)
+            out += compactSource(text);
+        else
+            out += text;
+    }
+
+    struct PrintBuffer {
+        std::string data;
+        std::vector<unsigned> offsets;
+    };
+}
+
+CXString clang_Cursor_printSource(CXCursor C, unsigned options)
+{
+    std::string text;
+    printCursor(C, options, text);
+    return clang::cxstring::createDup(text);
+}
+
+CXPrintBuffer clang_printCursors(const CXCursor *cursors, unsigned num_cursors, unsigned options)
+{
+    PrintBuffer *buffer = new PrintBuffer();
+    buffer->offsets.reserve(num_cursors + 1);
+    buffer->offsets.push_back(0);
+    for (unsigned i = 0; i < num_cursors; ++i) {
+        printCursor(cursors[i], options, buffer->data);
+        buffer->offsets.push_back(buffer->data.size());
+    }
+    return buffer;
+}
+
+const char *clang_PrintBuffer_getData(CXPrintBuffer B, unsigned *length)
+{
+    PrintBuffer *buffer = static_cast<PrintBuffer *>(B);
+    if (length)
+        *length = buffer ? buffer->data.size() : 0;
+    return buffer ? buffer->data.data() : nullptr;
+}
+
+const unsigned *clang_PrintBuffer_getOffsets(CXPrintBuffer B)
+{
+    return B ? static_cast<PrintBuffer *>(B)->offsets.data() : nullptr;
+}
+
+void clang_PrintBuffer_dispose(CXPrintBuffer B)
+{
+    delete static_cast<PrintBuffer *>(B);
+}
+
+/************************************************************************
+ * Loop nests
+ *
+ * Loop-nest forest of a translation unit, with the induction variable,
+ * constant bounds and step of canonical for loops.
+ ************************************************************************/
+
+namespace {
+    struct LoopNest {
+        std::vector<CXLoopInfo> loops;
+        std::vector<CXCursor> cursors;
+        std::vector<CXCursor> inductionVariables;
+        std::vector<CXCursor> arrays;
+    };
+
+    bool isReferenceTo(const clang::Expr *E, const clang::VarDecl *V)
+    {
+        const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(E->IgnoreParenImpCasts());
+        return ref && ref->getDecl() == V;
+    }
+
+    bool evaluateLoopConstant(const clang::Expr *E, const clang::ASTContext &context, long long &value)
+    {
+        clang::Expr::EvalResult result;
+        if (E->isValueDependent() || E->isTypeDependent() || !E->EvaluateAsInt(result, context))
+            return false;
+
+        const llvm::APSInt &v = result.Val.getInt();
+        if (v.isSigned() ? v.getMinSignedBits() > 64 : v.getActiveBits() > 63)
+            return false;
+        value = v.getExtValue();
+        return true;
+    }
+
+    /// The array or pointer declaration an array subscript indexes.
+    const clang::ValueDecl *getSubscriptedDecl(const clang::ArraySubscriptExpr *E)
+    {
+        const clang::Expr *base = E->getBase()->IgnoreParenImpCasts();
+        while (const clang::ArraySubscriptExpr *inner = clang::dyn_cast<clang::ArraySubscriptExpr>(base))
+            base = inner->getBase()->IgnoreParenImpCasts();
+
+        if (const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(base))
+            return ref->getDecl();
+        if (const clang::MemberExpr *member = clang::dyn_cast<clang::MemberExpr>(base))
+            return member->getMemberDecl();
+        return nullptr;
+    }
+
+    const clang::Stmt *getLoopBody(const clang::Stmt *S)
+    {
+        if (const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(S))
+            return loop->getBody();
+        if (const clang::WhileStmt *loop = clang::dyn_cast<clang::WhileStmt>(S))
+            return loop->getBody();
+        if (const clang::DoStmt *loop = clang::dyn_cast<clang::DoStmt>(S))
+            return loop->getBody();
+        if (const clang::CXXForRangeStmt *loop = clang::dyn_cast<clang::CXXForRangeStmt>(S))
+            return loop->getBody();
+        return nullptr;
+    }
+
+    class LoopNestBuilder {
+    public:
+        LoopNestBuilder(const clang::ASTContext &context, CXTranslationUnit TU, LoopNest &nest)
+            : context(context), TU(TU), nest(nest) {}
+
+        void walk(const clang::Stmt *S, const clang::Decl *parentDecl, int parent) {
+            if (!S)
+                return;
+
+            // The children of a CapturedStmt, e.g. the associated statement
+            // of an OpenMP directive, are only its capture initializers.
+            if (const clang::CapturedStmt *captured = clang::dyn_cast<clang::CapturedStmt>(S)) {
+                walk(captured->getCapturedStmt(), parentDecl, parent);
+                return;
+            }
+
+            if (const clang::ArraySubscriptExpr *subscript = clang::dyn_cast<clang::ArraySubscriptExpr>(S))
+                if (const clang::ValueDecl *D = getSubscriptedDecl(subscript))
+                    for (int loop = parent; loop >= 0; loop = nest.loops[loop].parent)
+                        addArray(loop, D);
+
+            const clang::Stmt *body = getLoopBody(S);
+            if (!body) {
+                for (const clang::Stmt *child : S->children())
+                    walk(child, parentDecl, parent);
+                return;
+            }
+
+            int index = addLoop(S, parentDecl, parent);
+            for (const clang::Stmt *child : S->children())
+                walk(child, parentDecl, child == body ? index : parent);
+        }
+
+        /// Flattens the per-loop array lists.
+        void finish() {
+            for (unsigned i = 0; i < nest.loops.size(); ++i) {
+                nest.loops[i].first_array = nest.arrays.size();
+                nest.loops[i].num_arrays = arrays[i].size();
+                for (const clang::ValueDecl *D : arrays[i])
+                    nest.arrays.push_back(clang::cxcursor::MakeCXCursor(D, TU));
+            }
+        }
+
+    private:
+        int addLoop(const clang::Stmt *S, const clang::Decl *parentDecl, int parent) {
+            CXLoopInfo info = CXLoopInfo();
+            CXCursor cursor = clang::cxcursor::MakeCXCursor(S, parentDecl, TU);
+            info.kind = cursor.kind;
+            info.parent = parent;
+            info.depth = parent >= 0 ? nest.loops[parent].depth + 1 : 0;
+            info.comparison = -1;
+
+            const clang::VarDecl *var = nullptr;
+            if (const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(S))
+                var = analyzeFor(loop, info);
+
+            nest.loops.push_back(info);
+            nest.cursors.push_back(cursor);
+            nest.inductionVariables.push_back(
+                var ? clang::cxcursor::MakeCXCursor(var, TU)
+                    : clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile));
+            arrays.emplace_back();
+            return nest.loops.size() - 1;
+        }
+
+        void addArray(int loop, const clang::ValueDecl *D) {
+            std::vector<const clang::ValueDecl *> &decls = arrays[loop];
+            if (std::find(decls.begin(), decls.end(), D) == decls.end())
+                decls.push_back(D);
+        }
+
+        /// Matches `init; var op bound; step` with an integer var; returns
+        /// the induction variable of canonical loops.
+        const clang::VarDecl *analyzeFor(const clang::ForStmt *loop, CXLoopInfo &info) {
+            const clang::VarDecl *var = nullptr;
+            const clang::Expr *lower = nullptr;
+            if (const clang::DeclStmt *DS = clang::dyn_cast_or_null<clang::DeclStmt>(loop->getInit())) {
+                if (DS->isSingleDecl()) {
+                    var = clang::dyn_cast<clang::VarDecl>(DS->getSingleDecl());
+                    lower = var ? var->getInit() : nullptr;
+                }
+            } else if (const clang::Expr *E = clang::dyn_cast_or_null<clang::Expr>(loop->getInit())) {
+                const clang::BinaryOperator *assign = clang::dyn_cast<clang::BinaryOperator>(E->IgnoreParens());
+                if (assign && assign->getOpcode() == clang::BO_Assign) {
+                    if (const clang::DeclRefExpr *ref =
+                            clang::dyn_cast<clang::DeclRefExpr>(assign->getLHS()->IgnoreParenImpCasts())) {
+                        var = clang::dyn_cast<clang::VarDecl>(ref->getDecl());
+                        lower = assign->getRHS();
+                    }
+                }
+            }
+            if (!var || !lower || !var->getType()->isIntegerType())
+                return nullptr;
+
+            // Condition, with the induction variable on the left.
+            const clang::BinaryOperator *cond =
+                clang::dyn_cast_or_null<clang::BinaryOperator>(loop->getCond() ? loop->getCond()->IgnoreParenImpCasts() : nullptr);
+            if (!cond || !(cond->isRelationalOp() || cond->getOpcode() == clang::BO_NE))
+                return nullptr;
+
+            clang::BinaryOperatorKind comparison = cond->getOpcode();
+            const clang::Expr *upper = nullptr;
+            if (isReferenceTo(cond->getLHS(), var)) {
+                upper = cond->getRHS();
+            } else if (isReferenceTo(cond->getRHS(), var)) {
+                upper = cond->getLHS();
+                if (comparison != clang::BO_NE)
+                    comparison = clang::BinaryOperator::reverseComparisonOp(comparison);
+            } else {
+                return nullptr;
+            }
+
+            // Increment: ++/--, += / -=, or var = var +/- step.
+            const clang::Expr *inc = loop->getInc() ? loop->getInc()->IgnoreParens() : nullptr;
+            const clang::Expr *step = nullptr;
+            bool negate = false;
+            bool unit = false;
+            if (const clang::UnaryOperator *op = clang::dyn_cast_or_null<clang::UnaryOperator>(inc)) {
+                if (!op->isIncrementDecrementOp() || !isReferenceTo(op->getSubExpr(), var))
+                    return nullptr;
+                unit = true;
+                negate = op->isDecrementOp();
+            } else if (const clang::BinaryOperator *op = clang::dyn_cast_or_null<clang::BinaryOperator>(inc)) {
+                if (!isReferenceTo(op->getLHS(), var))
+                    return nullptr;
+
+                if (op->getOpcode() == clang::BO_AddAssign || op->getOpcode() == clang::BO_SubAssign) {
+                    step = op->getRHS();
+                    negate = op->getOpcode() == clang::BO_SubAssign;
+                } else if (op->getOpcode() == clang::BO_Assign) {
+                    const clang::BinaryOperator *rhs =
+                        clang::dyn_cast<clang::BinaryOperator>(op->getRHS()->IgnoreParenImpCasts());
+                    if (!rhs || !rhs->isAdditiveOp())
+                        return nullptr;
+                    if (isReferenceTo(rhs->getLHS(), var))
+                        step = rhs->getRHS();
+                    else if (rhs->getOpcode() == clang::BO_Add && isReferenceTo(rhs->getRHS(), var))
+                        step = rhs->getLHS();
+                    else
+                        return nullptr;
+                    negate = rhs->getOpcode() == clang::BO_Sub;
+                } else {
+                    return nullptr;
+                }
+            } else {
+                return nullptr;
+            }
+
+            info.flags |= CXLoop_Canonical;
+            info.comparison = comparison;
+            if (evaluateLoopConstant(lower, context, info.lower_bound))
+                info.flags |= CXLoop_ConstantLowerBound;
+            if (evaluateLoopConstant(upper, context, info.upper_bound))
+                info.flags |= CXLoop_ConstantUpperBound;
+
+            long long value = 1;
+            if (unit || evaluateLoopConstant(step, context, value)) {
+                info.step = negate ? -value : value;
+                info.flags |= CXLoop_ConstantStep;
+            }
+            return var;
+        }
+
+        const clang::ASTContext &context;
+        CXTranslationUnit TU;
+        LoopNest &nest;
+        std::vector<std::vector<const clang::ValueDecl *>> arrays;
+    };
+}
+
+CXLoopNest clang_TranslationUnit_getLoopNest(CXTranslationUnit TU, unsigned options)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    LoopNest *nest = new LoopNest();
+    LoopNestBuilder builder(unit->getASTContext(), TU, *nest);
+    BodyCollector(unit->getSourceManager(), options & CXLoopNest_MainFileOnly,
+                  [&](const clang::Stmt *body, const clang::Decl *D) { builder.walk(body, D, -1); })
+        .TraverseDecl(unit->getASTContext().getTranslationUnitDecl());
+    builder.finish();
+    return nest;
+}
+
+unsigned clang_LoopNest_getNumLoops(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->loops.size() : 0;
+}
+
+const CXLoopInfo *clang_LoopNest_getLoops(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->loops.data() : nullptr;
+}
+
+const CXCursor *clang_LoopNest_getCursors(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->cursors.data() : nullptr;
+}
+
+const CXCursor *clang_LoopNest_getInductionVariables(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->inductionVariables.data() : nullptr;
+}
+
+unsigned clang_LoopNest_getNumArrays(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->arrays.size() : 0;
+}
+
+const CXCursor *clang_LoopNest_getArrays(CXLoopNest N)
+{
+    return N ? static_cast<LoopNest *>(N)->arrays.data() : nullptr;
+}
+
+void clang_LoopNest_dispose(CXLoopNest N)
+{
+    delete static_cast<LoopNest *>(N);
+}
+
+/************************************************************************
+ * Header deduplication
+ *
+ * Hands out the top-level declarations of many translation units, skipping
+ * those of headers already handed out.
+ ************************************************************************/
+
+namespace {
+    struct HeaderDedup {
+        std::unordered_set<uint64_t> seen;
+        std::vector<CXCursor> cursors;
+        CXHeaderDedupStats stats;
+        CXHeaderDedupStats totals;
+    };
+
+    /// Hashes of the macros each file expands but does not define.
+    llvm::DenseMap<clang::FileID, uint64_t> getExternalMacroContexts(clang::ASTUnit *unit)
+    {
+        llvm::DenseMap<clang::FileID, uint64_t> contexts;
+        clang::PreprocessingRecord *record = unit->getPreprocessor().getPreprocessingRecord();
+        if (!record)
+            return contexts;
+
+        const clang::SourceManager &SM = unit->getSourceManager();
+        for (clang::PreprocessedEntity *entity : *record) {
+            clang::MacroExpansion *expansion = clang::dyn_cast_or_null<clang::MacroExpansion>(entity);
+            if (!expansion)
+                continue;
+
+            clang::FileID file = SM.getFileID(SM.getExpansionLoc(expansion->getSourceRange().getBegin()));
+            clang::MacroDefinitionRecord *def = expansion->getDefinition();
+            if (def && SM.getFileID(SM.getExpansionLoc(def->getLocation())) == file)
+                continue;
+
+            uint64_t &context = contexts[file];
+            context = hashMix(context, llvm::xxHash64(expansion->getName()->getName()));
+            if (def) {
+                clang::SourceLocation loc = SM.getExpansionLoc(def->getLocation());
+                context = hashMix(context, llvm::xxHash64(SM.getBufferName(loc)));
+                context = hashMix(context, SM.getFileOffset(loc));
+            }
+        }
+        return contexts;
+    }
+}
+
+CXHeaderDedup clang_HeaderDedup_create(void)
+{
+    HeaderDedup *dedup = new HeaderDedup();
+    dedup->stats = CXHeaderDedupStats();
+    dedup->totals = CXHeaderDedupStats();
+    return dedup;
+}
+
+unsigned clang_HeaderDedup_collect(CXHeaderDedup D, CXTranslationUnit TU)
+{
+    HeaderDedup *dedup = static_cast<HeaderDedup *>(D);
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!dedup || !unit)
+        return 0;
+
+    const clang::SourceManager &SM = unit->getSourceManager();
+    uint64_t config = llvm::xxHash64(unit->getPreprocessor().getPredefines());
+    llvm::DenseMap<clang::FileID, uint64_t> macroContexts = getExternalMacroContexts(unit);
+
+    // Header key and whether it was seen, per file of this unit.
+    llvm::DenseMap<clang::FileID, std::pair<uint64_t, bool>> headers;
+    std::unordered_set<uint64_t> keys;
+    CXHeaderDedupStats stats = CXHeaderDedupStats();
+    dedup->cursors.clear();
+
+    for (clang::Decl *decl : unit->getASTContext().getTranslationUnitDecl()->decls()) {
+        if (decl->isImplicit())
+            continue;
+
+        bool skip = false;
+        clang::FileID file = SM.getFileID(SM.getExpansionLoc(decl->getLocation()));
+        const clang::FileEntry *entry = file.isValid() ? SM.getFileEntryForID(file) : nullptr;
+        if (entry && file != SM.getMainFileID()) {
+            auto it = headers.find(file);
+            if (it == headers.end()) {
+                llvm::StringRef name = entry->tryGetRealPathName();
+                uint64_t key = hashMix(config, llvm::xxHash64(name.empty() ? entry->getName() : name));
+                key = hashMix(key, llvm::xxHash64(SM.getBufferData(file)));
+                key = hashMix(key, macroContexts.lookup(file));
+
+                bool seen = dedup->seen.count(key);
+                if (keys.insert(key).second) {
+                    ++stats.num_headers;
+                    stats.num_skipped_headers += seen;
+                }
+                it = headers.try_emplace(file, key, seen).first;
+            }
+            skip = it->second.second;
+        }
+
+        if (skip) {
+            ++stats.num_skipped_declarations;
+            continue;
+        }
+        ++stats.num_declarations;
+        dedup->cursors.push_back(clang::cxcursor::MakeCXCursor(decl, TU));
+    }
+
+    dedup->seen.insert(keys.begin(), keys.end());
+    dedup->stats = stats;
+    dedup->totals.num_headers += stats.num_headers;
+    dedup->totals.num_skipped_headers += stats.num_skipped_headers;
+    dedup->totals.num_declarations += stats.num_declarations;
+    dedup->totals.num_skipped_declarations += stats.num_skipped_declarations;
+    return stats.num_declarations;
+}
+
+const CXCursor *clang_HeaderDedup_getCursors(CXHeaderDedup D)
+{
+    return D ? static_cast<HeaderDedup *>(D)->cursors.data() : nullptr;
+}
+
+CXHeaderDedupStats clang_HeaderDedup_getStats(CXHeaderDedup D)
+{
+    return D ? static_cast<HeaderDedup *>(D)->stats : CXHeaderDedupStats();
+}
+
+CXHeaderDedupStats clang_HeaderDedup_getTotals(CXHeaderDedup D)
+{
+    return D ? static_cast<HeaderDedup *>(D)->totals : CXHeaderDedupStats();
+}
+
+unsigned clang_HeaderDedup_getNumHeaders(CXHeaderDedup D)
+{
+    return D ? static_cast<HeaderDedup *>(D)->seen.size() : 0;
+}
+
+void clang_HeaderDedup_dispose(CXHeaderDedup D)
+{
+    delete static_cast<HeaderDedup *>(D);
+}
+
+/************************************************************************
+ * Location maps
+ *
+ * Bulk mapping of locations to (file, line, column) through per-file
+ * line-start indexes.
+ ************************************************************************/
+
+namespace {
+    /// Offsets of the first character of each line; lines end with \n, \r,
+    /// \r\n or \n\r, as for clang.
+    std::vector<unsigned> computeLineStarts(llvm::StringRef buffer)
+    {
+        std::vector<unsigned> starts(1, 0);
+        const char *begin = buffer.data();
+        const char *end = begin + buffer.size();
+
+        if (!std::memchr(begin, '\r', buffer.size())) {
+            // memchr is vectorized by the C library.
+            for (const char *p = begin; p < end; ++p) {
+                p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+                if (!p)
+                    break;
+                starts.push_back(p - begin + 1);
+            }
+            return starts;
+        }
+
+        for (const char *p = begin; p < end; ++p) {
+            if (*p != '\n' && *p != '\r')
+                continue;
+            if (p + 1 < end && (p[1] == '\n' || p[1] == '\r') && p[1] != *p)
+                ++p;
+            starts.push_back(p - begin + 1);
+        }
+        return starts;
+    }
+
+    struct LocationMap {
+        struct File {
+            clang::FileID id;
+            std::vector<unsigned> lineStarts;
+            unsigned size;
+            bool indexed;
+            unsigned lastLine;
+        };
+
+        clang::ASTUnit *unit;
+        std::vector<File> files;
+        llvm::DenseMap<clang::FileID, unsigned> fileIds;
+
+        unsigned getFileId(clang::FileID id) {
+            auto inserted = fileIds.try_emplace(id, files.size());
+            if (inserted.second)
+                files.push_back({id, {}, 0, false, 0});
+            return inserted.first->second;
+        }
+
+        void mapOffset(unsigned file, unsigned offset, CXLineColumn &out) {
+            File &info = files[file];
+            if (!info.indexed) {
+                llvm::StringRef buffer = unit->getSourceManager().getBufferData(info.id);
+                info.lineStarts = computeLineStarts(buffer);
+                info.size = buffer.size();
+                info.indexed = true;
+            }
+
+            // The end of the buffer is a valid location, past it is not.
+            if (offset > info.size) {
+                out = {~0U, 0, 0, 0};
+                return;
+            }
+
+            // Nearby locations are mapped in a row; try the last line first.
+            const std::vector<unsigned> &starts = info.lineStarts;
+            unsigned line = info.lastLine;
+            if (!(starts[line] <= offset && (line + 1 == starts.size() || offset < starts[line + 1])))
+                line = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+            info.lastLine = line;
+
+            out.file = file;
+            out.line = line + 1;
+            out.column = offset - starts[line] + 1;
+            out.offset = offset;
+        }
+
+        void map(clang::SourceLocation loc, CXLineColumn &out) {
+            if (loc.isInvalid()) {
+                out = {~0U, 0, 0, 0};
+                return;
+            }
+
+            std::pair<clang::FileID, unsigned> decomposed =
+                unit->getSourceManager().getDecomposedExpansionLoc(loc);
+            if (decomposed.first.isInvalid()) {
+                out = {~0U, 0, 0, 0};
+                return;
+            }
+            mapOffset(getFileId(decomposed.first), decomposed.second, out);
+        }
+
+        void map(CXSourceLocation loc, CXLineColumn &out) {
+            if (loc.ptr_data[0] != &unit->getSourceManager()) {
+                out = {~0U, 0, 0, 0};
+                return;
+            }
+            map(clang::SourceLocation::getFromRawEncoding(loc.int_data), out);
+        }
+    };
+}
+
+CXLocationMap clang_LocationMap_create(CXTranslationUnit TU)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    LocationMap *map = new LocationMap();
+    map->unit = unit;
+    return map;
+}
+
+void clang_LocationMap_mapCursors(CXLocationMap M, const CXCursor *cursors, unsigned num_cursors,
+                                  enum CXLocationMapPosition position, CXLineColumn *out)
+{
+    LocationMap *map = static_cast<LocationMap *>(M);
+    if (!map)
+        return;
+
+    for (unsigned i = 0; i < num_cursors; ++i) {
+        CXSourceLocation loc;
+        if (position == CXLocationMap_Location)
+            loc = clang_getCursorLocation(cursors[i]);
+        else if (position == CXLocationMap_ExtentStart)
+            loc = clang_getRangeStart(clang_getCursorExtent(cursors[i]));
+        else
+            loc = clang_getRangeEnd(clang_getCursorExtent(cursors[i]));
+        map->map(loc, out[i]);
+    }
+}
+
+void clang_LocationMap_mapLocations(CXLocationMap M, const CXSourceLocation *locations,
+                                    unsigned num_locations, CXLineColumn *out)
+{
+    LocationMap *map = static_cast<LocationMap *>(M);
+    if (!map)
+        return;
+
+    for (unsigned i = 0; i < num_locations; ++i)
+        map->map(locations[i], out[i]);
+}
+
+void clang_LocationMap_mapOffsets(CXLocationMap M, unsigned file, const unsigned *offsets,
+                                  unsigned num_offsets, CXLineColumn *out)
+{
+    LocationMap *map = static_cast<LocationMap *>(M);
+    if (!map)
+        return;
+
+    for (unsigned i = 0; i < num_offsets; ++i) {
+        if (file >= map->files.size())
+            out[i] = {~0U, 0, 0, 0};
+        else
+            map->mapOffset(file, offsets[i], out[i]);
+    }
+}
+
+int clang_LocationMap_getFileId(CXLocationMap M, const char *name)
+{
+    LocationMap *map = static_cast<LocationMap *>(M);
+    if (!map || !name)
+        return -1;
+
+    clang::SourceManager &SM = map->unit->getSourceManager();
+    auto entry = SM.getFileManager().getFile(name);
+    if (!entry)
+        return -1;
+
+    clang::FileID id = SM.translateFile(*entry);
+    if (id.isInvalid())
+        return -1;
+    return map->getFileId(id);
+}
+
+unsigned clang_LocationMap_getNumFiles(CXLocationMap M)
+{
+    return M ? static_cast<LocationMap *>(M)->files.size() : 0;
+}
+
+CXString clang_LocationMap_getFileName(CXLocationMap M, unsigned file)
+{
+    LocationMap *map = static_cast<LocationMap *>(M);
+    if (!map || file >= map->files.size())
+        return clang::cxstring::createEmpty();
+
+    const clang::SourceManager &SM = map->unit->getSourceManager();
+    const clang::FileEntry *entry = SM.getFileEntryForID(map->files[file].id);
+    if (entry)
+        return clang::cxstring::createDup(entry->getName());
+    return clang::cxstring::createDup(SM.getBufferName(SM.getLocForStartOfFile(map->files[file].id)));
+}
+
+void clang_LocationMap_dispose(CXLocationMap M)
+{
+    delete static_cast<LocationMap *>(M);
+}
+
+/************************************************************************
+ * Top-k completion
+ *
+ * Code completion filtered by a typed prefix and ranked natively, rendering
+ * only the results that are kept.
+ ************************************************************************/
+
+namespace {
+    struct TopCompletions {
+        unsigned numCandidates;
+        std::vector<CXTopCompletionResult> results;
+        std::string strings;
+
+        unsigned addString(llvm::StringRef text) {
+            unsigned offset = strings.size();
+            strings.append(text.data(), text.size());
+            strings += '\0';
+            return offset;
+        }
+    };
+
+    /// Subsequence match of pattern in word, case-insensitively; -1 when
+    /// pattern does not match.
+    int fuzzyMatchScore(llvm::StringRef pattern, llvm::StringRef word)
+    {
+        if (pattern.empty())
+            return 0;
+
+        int score = 0;
+        if (word.startswith(pattern))
+            score += 150;
+        else if (word.startswith_lower(pattern))
+            score += 100;
+
+        size_t p = 0;
+        size_t last = llvm::StringRef::npos;
+        for (size_t i = 0; i < word.size() && p < pattern.size(); ++i) {
+            if (clang::toLowercase(word[i]) != clang::toLowercase(pattern[p]))
+                continue;
+
+            bool boundary = i == 0 || word[i - 1] == '_' ||
+                            (clang::isLowercase(word[i - 1]) && clang::isUppercase(word[i]));
+            if (boundary)
+                score += 8;
+            if (last != llvm::StringRef::npos && last + 1 == i)
+                score += 5;
+            if (word[i] == pattern[p])
+                score += 1;
+            // Penalize skipped characters.
+            score -= static_cast<int>(std::min<size_t>(i - (last == llvm::StringRef::npos ? 0 : last + 1), 3));
+
+            last = i;
+            ++p;
+        }
+        return p == pattern.size() ? score : -1;
+    }
+
+    llvm::StringRef getChunkText(CXCompletionString completion, unsigned chunk, CXString &text)
+    {
+        text = clang_getCompletionChunkText(completion, chunk);
+        const char *data = clang_getCString(text);
+        return data ? llvm::StringRef(data) : llvm::StringRef();
+    }
+
+    /// Appends the chunks of completion, except the result type and optional
+    /// chunks, to signature.
+    void renderCompletion(CXCompletionString completion, std::string &resultType, std::string &signature)
+    {
+        for (unsigned i = 0, n = clang_getNumCompletionChunks(completion); i < n; ++i) {
+            CXCompletionChunkKind kind = clang_getCompletionChunkKind(completion, i);
+            if (kind == CXCompletionChunk_Optional)
+                continue;
+
+            CXString text;
+            llvm::StringRef chunk = getChunkText(completion, i, text);
+            if (kind == CXCompletionChunk_ResultType)
+                resultType += chunk;
+            else
+                signature += chunk;
+            clang_disposeString(text);
+        }
+    }
+}
+
+CXTopCompletions clang_codeCompleteTopK(CXTranslationUnit TU, const char *complete_filename,
+                                        unsigned complete_line, unsigned complete_column,
+                                        struct CXUnsavedFile *unsaved_files,
+                                        unsigned num_unsaved_files, unsigned options,
+                                        const char *prefix, unsigned limit)
+{
+    CXCodeCompleteResults *completions =
+        clang_codeCompleteAt(TU, complete_filename, complete_line, complete_column, unsaved_files,
+                             num_unsaved_files, options);
+    if (!completions)
+        return nullptr;
+
+    llvm::StringRef pattern = prefix ? prefix : "";
+    struct Match {
+        int score;
+        unsigned priority;
+        std::string typedText;
+        unsigned index;
+    };
+    std::vector<Match> matches;
+
+    for (unsigned i = 0; i < completions->NumResults; ++i) {
+        CXCompletionString completion = completions->Results[i].CompletionString;
+        if (clang_getCompletionAvailability(completion) == CXAvailability_NotAvailable)
+            continue;
+
+        for (unsigned chunk = 0, n = clang_getNumCompletionChunks(completion); chunk < n; ++chunk) {
+            if (clang_getCompletionChunkKind(completion, chunk) != CXCompletionChunk_TypedText)
+                continue;
+
+            CXString text;
+            llvm::StringRef typedText = getChunkText(completion, chunk, text);
+            int score = fuzzyMatchScore(pattern, typedText);
+            if (score >= 0)
+                matches.push_back({score, clang_getCompletionPriority(completion), typedText.str(), i});
+            clang_disposeString(text);
+            break;
+        }
+    }
+
+    auto better = [](const Match &a, const Match &b) {
+        return std::make_tuple(-a.score, a.priority, llvm::StringRef(a.typedText), a.index) <
+               std::make_tuple(-b.score, b.priority, llvm::StringRef(b.typedText), b.index);
+    };
+    size_t kept = std::min<size_t>(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + kept, matches.end(), better);
+
+    TopCompletions *top = new TopCompletions();
+    top->numCandidates = completions->NumResults;
+    for (size_t i = 0; i < kept; ++i) {
+        const CXCompletionResult &result = completions->Results[matches[i].index];
+        std::string resultType;
+        std::string signature;
+        renderCompletion(result.CompletionString, resultType, signature);
+
+        CXTopCompletionResult info;
+        info.kind = result.CursorKind;
+        info.priority = matches[i].priority;
+        info.availability = clang_getCompletionAvailability(result.CompletionString);
+        info.score = matches[i].score;
+        info.typed_text = top->addString(matches[i].typedText);
+        info.result_type = top->addString(resultType);
+        info.signature = top->addString(signature);
+        top->results.push_back(info);
+    }
+
+    clang_disposeCodeCompleteResults(completions);
+    return top;
+}
+
+unsigned clang_TopCompletions_getNumCandidates(CXTopCompletions C)
+{
+    return C ? static_cast<TopCompletions *>(C)->numCandidates : 0;
+}
+
+unsigned clang_TopCompletions_getNumResults(CXTopCompletions C)
+{
+    return C ? static_cast<TopCompletions *>(C)->results.size() : 0;
+}
+
+const CXTopCompletionResult *clang_TopCompletions_getResults(CXTopCompletions C)
+{
+    return C ? static_cast<TopCompletions *>(C)->results.data() : nullptr;
+}
+
+const char *clang_TopCompletions_getStrings(CXTopCompletions C, unsigned *length)
+{
+    TopCompletions *top = static_cast<TopCompletions *>(C);
+    if (length)
+        *length = top ? top->strings.size() : 0;
+    return top ? top->strings.data() : nullptr;
+}
+
+void clang_TopCompletions_dispose(CXTopCompletions C)
+{
+    delete static_cast<TopCompletions *>(C);
+}
+
+/************************************************************************
+ * OpenMP directives
+ *
+ * Executable OpenMP directives of a translation unit with their clauses and
+ * the statement or loop nest they govern.
+ ************************************************************************/
+
+namespace {
+    struct OMPDirectives {
+        std::vector<CXOMPDirectiveInfo> directives;
+        std::vector<CXCursor> cursors;
+        std::vector<CXCursor> associated;
+        std::vector<CXOMPClauseInfo> clauses;
+        std::vector<CXCursor> variables;
+        std::vector<long long> arguments;
+        std::string strings;
+        llvm::StringMap<unsigned> stringIds;
+
+        unsigned addString(llvm::StringRef text) {
+            auto inserted = stringIds.try_emplace(text, strings.size());
+            if (inserted.second) {
+                strings.append(text.data(), text.size());
+                strings += '\0';
+            }
+            return inserted.first->second;
+        }
+    };
+
+    /// The variable or field a clause expression names, looking through
+    /// subscripts and array sections.
+    const clang::ValueDecl *getClauseVariable(const clang::Expr *E)
+    {
+        E = E->IgnoreParenImpCasts();
+        for (;;) {
+            if (const clang::ArraySubscriptExpr *subscript = clang::dyn_cast<clang::ArraySubscriptExpr>(E))
+                E = subscript->getBase()->IgnoreParenImpCasts();
+            else if (const clang::OMPArraySectionExpr *section = clang::dyn_cast<clang::OMPArraySectionExpr>(E))
+                E = section->getBase()->IgnoreParenImpCasts();
+            else
+                break;
+        }
+
+        const clang::ValueDecl *D = nullptr;
+        if (const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(E))
+            D = ref->getDecl();
+        else if (const clang::MemberExpr *member = clang::dyn_cast<clang::MemberExpr>(E))
+            D = member->getMemberDecl();
+
+        // Sema captures non-constant arguments in implicit helper variables.
+        if (!D || D->isImplicit() || !(clang::isa<clang::VarDecl>(D) || clang::isa<clang::FieldDecl>(D)))
+            return nullptr;
+        return D;
+    }
+
+    std::string getReductionIdentifier(const clang::DeclarationNameInfo &name)
+    {
+        clang::DeclarationName N = name.getName();
+        if (N.getNameKind() == clang::DeclarationName::CXXOperatorName)
+            return clang::getOperatorSpelling(N.getCXXOverloadedOperator());
+        return N.getAsString();
+    }
+
+    /// The kind argument of the clause, e.g. "dynamic" for schedule(dynamic),
+    /// or its reduction identifier.
+    std::string getClauseModifier(const clang::OMPClause *C)
+    {
+        clang::OpenMPClauseKind kind = C->getClauseKind();
+        if (const clang::OMPScheduleClause *clause = clang::dyn_cast<clang::OMPScheduleClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, clause->getScheduleKind());
+        if (const clang::OMPDistScheduleClause *clause = clang::dyn_cast<clang::OMPDistScheduleClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, clause->getDistScheduleKind());
+        if (const clang::OMPDefaultClause *clause = clang::dyn_cast<clang::OMPDefaultClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, unsigned(clause->getDefaultKind()));
+        if (const clang::OMPProcBindClause *clause = clang::dyn_cast<clang::OMPProcBindClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, unsigned(clause->getProcBindKind()));
+        if (const clang::OMPDependClause *clause = clang::dyn_cast<clang::OMPDependClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, clause->getDependencyKind());
+        if (const clang::OMPMapClause *clause = clang::dyn_cast<clang::OMPMapClause>(C))
+            return clang::getOpenMPSimpleClauseTypeName(kind, clause->getMapType());
+        if (const clang::OMPReductionClause *clause = clang::dyn_cast<clang::OMPReductionClause>(C))
+            return getReductionIdentifier(clause->getNameInfo());
+        if (const clang::OMPTaskReductionClause *clause = clang::dyn_cast<clang::OMPTaskReductionClause>(C))
+            return getReductionIdentifier(clause->getNameInfo());
+        if (const clang::OMPInReductionClause *clause = clang::dyn_cast<clang::OMPInReductionClause>(C))
+            return getReductionIdentifier(clause->getNameInfo());
+        return std::string();
+    }
+
+    /// The outermost loop a loop directive is associated with.
+    const clang::Stmt *getDirectiveLoop(const clang::OMPLoopDirective *D)
+    {
+        if (!D->hasAssociatedStmt() || !D->getAssociatedStmt())
+            return nullptr;
+        const clang::Stmt *S = D->getInnermostCapturedStmt()->getCapturedStmt()->IgnoreContainers(true);
+        return getLoopBody(S) ? S : nullptr;
+    }
+
+    class OMPDirectiveCollector {
+    public:
+        OMPDirectiveCollector(const clang::ASTContext &context, CXTranslationUnit TU, OMPDirectives &result)
+            : context(context), TU(TU), result(result) {}
+
+        void walk(const clang::Stmt *S, const clang::Decl *parentDecl, int parent) {
+            if (!S)
+                return;
+
+            // The children of a CapturedStmt are only its capture
+            // initializers.
+            if (const clang::CapturedStmt *captured = clang::dyn_cast<clang::CapturedStmt>(S)) {
+                walk(captured->getCapturedStmt(), parentDecl, parent);
+                return;
+            }
+
+            const clang::OMPExecutableDirective *D = clang::dyn_cast<clang::OMPExecutableDirective>(S);
+            if (!D) {
+                for (const clang::Stmt *child : S->children())
+                    walk(child, parentDecl, parent);
+                return;
+            }
+
+            // Nested directives are in the body of the innermost capture of
+            // the associated statement.
+            int index = addDirective(D, parentDecl, parent);
+            if (D->hasAssociatedStmt() && D->getAssociatedStmt())
+                walk(D->getInnermostCapturedStmt()->getCapturedStmt(), parentDecl, index);
+        }
+
+    private:
+        int addDirective(const clang::OMPExecutableDirective *D, const clang::Decl *parentDecl, int parent) {
+            CXOMPDirectiveInfo info = CXOMPDirectiveInfo();
+            CXCursor cursor = clang::cxcursor::MakeCXCursor(D, parentDecl, TU);
+            info.kind = cursor.kind;
+            info.parent = parent;
+            info.depth = parent >= 0 ? result.directives[parent].depth + 1 : 0;
+            info.name = result.addString(llvm::omp::getOpenMPDirectiveName(D->getDirectiveKind()));
+
+            const clang::Stmt *associated = nullptr;
+            if (const clang::OMPLoopDirective *loop = clang::dyn_cast<clang::OMPLoopDirective>(D)) {
+                info.flags |= CXOMPDirective_Loop;
+                info.collapse = loop->getCollapsedNumber();
+                associated = getDirectiveLoop(loop);
+            } else if (D->isStandaloneDirective()) {
+                info.flags |= CXOMPDirective_Standalone;
+            } else {
+                associated = D->getStructuredBlock();
+            }
+
+            info.first_clause = result.clauses.size();
+            for (const clang::OMPClause *clause : D->clauses()) {
+                if (clause && !clause->isImplicit())
+                    addClause(clause);
+            }
+            info.num_clauses = result.clauses.size() - info.first_clause;
+
+            result.directives.push_back(info);
+            result.cursors.push_back(cursor);
+            result.associated.push_back(
+                associated ? clang::cxcursor::MakeCXCursor(associated, parentDecl, TU)
+                           : clang::cxcursor::MakeCXCursorInvalid(CXCursor_InvalidFile));
+            return result.directives.size() - 1;
+        }
+
+        void addClause(const clang::OMPClause *C) {
+            CXOMPClauseInfo info = CXOMPClauseInfo();
+            info.kind = static_cast<unsigned>(C->getClauseKind());
+            info.name = result.addString(llvm::omp::getOpenMPClauseName(C->getClauseKind()));
+            info.modifier = result.addString(getClauseModifier(C));
+            info.first_variable = result.variables.size();
+            info.first_argument = result.arguments.size();
+
+            // Variable lists and expression arguments; the linear step and
+            // the alignment are kept out of the children.
+            for (const clang::Stmt *child : C->children())
+                addOperand(clang::dyn_cast_or_null<clang::Expr>(child));
+            if (const clang::OMPLinearClause *linear = clang::dyn_cast<clang::OMPLinearClause>(C))
+                addOperand(linear->getStep());
+            else if (const clang::OMPAlignedClause *aligned = clang::dyn_cast<clang::OMPAlignedClause>(C))
+                addOperand(aligned->getAlignment());
+
+            info.num_variables = result.variables.size() - info.first_variable;
+            info.num_arguments = result.arguments.size() - info.first_argument;
+            result.clauses.push_back(info);
+        }
+
+        void addOperand(const clang::Expr *E) {
+            if (!E)
+                return;
+
+            long long value;
+            if (const clang::ValueDecl *D = getClauseVariable(E))
+                result.variables.push_back(clang::cxcursor::MakeCXCursor(D, TU));
+            else if (evaluateLoopConstant(E, context, value))
+                result.arguments.push_back(value);
+        }
+
+        const clang::ASTContext &context;
+        CXTranslationUnit TU;
+        OMPDirectives &result;
+    };
+}
+
+CXOMPDirectives clang_TranslationUnit_getOMPDirectives(CXTranslationUnit TU, unsigned options)
+{
+    clang::ASTUnit *unit = clang::cxtu::getASTUnit(TU);
+    if (!unit)
+        return nullptr;
+
+    OMPDirectives *result = new OMPDirectives();
+    result->addString("");
+    OMPDirectiveCollector collector(unit->getASTContext(), TU, *result);
+    BodyCollector(unit->getSourceManager(), options & CXOMPDirectives_MainFileOnly,
+                  [&](const clang::Stmt *body, const clang::Decl *D) { collector.walk(body, D, -1); })
+        .TraverseDecl(unit->getASTContext().getTranslationUnitDecl());
+    return result;
+}
+
+unsigned clang_OMPDirectives_getNumDirectives(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->directives.size() : 0;
+}
+
+const CXOMPDirectiveInfo *clang_OMPDirectives_getDirectives(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->directives.data() : nullptr;
+}
+
+const CXCursor *clang_OMPDirectives_getCursors(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->cursors.data() : nullptr;
+}
+
+const CXCursor *clang_OMPDirectives_getAssociated(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->associated.data() : nullptr;
+}
+
+unsigned clang_OMPDirectives_getNumClauses(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->clauses.size() : 0;
+}
+
+const CXOMPClauseInfo *clang_OMPDirectives_getClauses(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->clauses.data() : nullptr;
+}
+
+unsigned clang_OMPDirectives_getNumVariables(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->variables.size() : 0;
+}
+
+const CXCursor *clang_OMPDirectives_getVariables(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->variables.data() : nullptr;
+}
+
+unsigned clang_OMPDirectives_getNumArguments(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->arguments.size() : 0;
+}
+
+const long long *clang_OMPDirectives_getArguments(CXOMPDirectives D)
+{
+    return D ? static_cast<OMPDirectives *>(D)->arguments.data() : nullptr;
+}
+
+const char *clang_OMPDirectives_getStrings(CXOMPDirectives D, unsigned *length)
+{
+    OMPDirectives *result = static_cast<OMPDirectives *>(D);
+    if (length)
+        *length = result ? result->strings.size() : 0;
+    return result ? result->strings.data() : nullptr;
+}
+
+void clang_OMPDirectives_dispose(CXOMPDirectives D)
+{
+    delete static_cast<OMPDirectives *>(D);
+}
+
 /************************************************************************
  * Python module definition
  *
@@ -61,6 +61,1029 @@ EXPORT_PREFIX CXCursor clang_getForStmtInc(CXCursor C);
  */
 EXPORT_PREFIX CXCursor clang_getForStmtBody(CXCursor C);
 
+/**
+ * \brief An opaque handle to the include graph of a translation unit.
+ */
+typedef void *CXIncludeGraph;
+
+/**
+ * \brief A single #include directive of an include graph. Files are
+ * referred to by their index in the graph.
+ */
+typedef struct {
+    unsigned includer;
+    unsigned included;
+    unsigned line;
+    unsigned column;
+    unsigned offset;
+} CXIncludeEdge;
+
+/**
+ * \brief Per-file annotations of an include graph. Times are wall-clock
+ * seconds; self_time excludes the time spent in nested includes, total_time
+ * includes it. Times and token counts are only collected by
+ * clang_profileIncludeGraph.
+ */
+typedef struct {
+    unsigned depth;
+    unsigned num_entries;
+    unsigned long long num_tokens;
+    unsigned long long size;
+    double self_time;
+    double total_time;
+} CXIncludeFileStats;
+
+/**
+ * \brief Returns the include graph of an already parsed translation unit, or
+ * NULL if TU is invalid. The graph must be released with
+ * clang_IncludeGraph_dispose. With a preprocessing record
+ * (CXTranslationUnit_DetailedPreprocessingRecord) the edges are every
+ * inclusion directive, as for clang_profileIncludeGraph; otherwise
+ * directives skipped by an include guard or #pragma once have no edge.
+ */
+EXPORT_PREFIX CXIncludeGraph clang_TranslationUnit_getIncludeGraph(CXTranslationUnit TU);
+
+/**
+ * \brief Parses source_filename (syntax only) with the given command line and
+ * returns its include graph annotated with per-file preprocessing/parse
+ * times and expanded token counts, or NULL if no compiler invocation could
+ * be built from the arguments.
+ */
+EXPORT_PREFIX CXIncludeGraph clang_profileIncludeGraph(const char *source_filename,
+                                                       const char *const *command_line_args,
+                                                       int num_command_line_args,
+                                                       struct CXUnsavedFile *unsaved_files,
+                                                       unsigned num_unsaved_files);
+
+/**
+ * \brief Returns the number of distinct files in the include graph.
+ */
+EXPORT_PREFIX unsigned clang_IncludeGraph_getNumFiles(CXIncludeGraph G);
+
+/**
+ * \brief Returns the name of the file with the given index.
+ */
+EXPORT_PREFIX CXString clang_IncludeGraph_getFileName(CXIncludeGraph G, unsigned index);
+
+/**
+ * \brief Returns an array of clang_IncludeGraph_getNumFiles() file stats,
+ * indexed by file.
+ */
+EXPORT_PREFIX const CXIncludeFileStats *clang_IncludeGraph_getFileStats(CXIncludeGraph G);
+
+/**
+ * \brief Returns the number of #include directives in the include graph.
+ */
+EXPORT_PREFIX unsigned clang_IncludeGraph_getNumEdges(CXIncludeGraph G);
+
+/**
+ * \brief Returns an array of clang_IncludeGraph_getNumEdges() edges, in the
+ * order the directives were seen.
+ */
+EXPORT_PREFIX const CXIncludeEdge *clang_IncludeGraph_getEdges(CXIncludeGraph G);
+
+/**
+ * \brief Releases an include graph.
+ */
+EXPORT_PREFIX void clang_IncludeGraph_dispose(CXIncludeGraph G);
+
+/**
+ * \brief An opaque handle to per-file include costs aggregated over many
+ * translation units.
+ */
+typedef void *CXIncludeCostTable;
+
+/**
+ * \brief Aggregated include costs of a single file.
+ */
+typedef struct {
+    unsigned num_translation_units;
+    unsigned num_includes;
+    unsigned min_depth;
+    unsigned long long num_tokens;
+    unsigned long long size;
+    double self_time;
+    double total_time;
+} CXIncludeCostEntry;
+
+/**
+ * \brief Creates an empty include cost table.
+ */
+EXPORT_PREFIX CXIncludeCostTable clang_IncludeCostTable_create(void);
+
+/**
+ * \brief Adds the files of an include graph to the table. Files are merged by
+ * name.
+ */
+EXPORT_PREFIX void clang_IncludeCostTable_add(CXIncludeCostTable T, CXIncludeGraph G);
+
+/**
+ * \brief Returns the number of distinct files in the table.
+ */
+EXPORT_PREFIX unsigned clang_IncludeCostTable_getNumFiles(CXIncludeCostTable T);
+
+/**
+ * \brief Returns the name of the file with the given index.
+ */
+EXPORT_PREFIX CXString clang_IncludeCostTable_getFileName(CXIncludeCostTable T, unsigned index);
+
+/**
+ * \brief Returns an array of clang_IncludeCostTable_getNumFiles() entries,
+ * indexed by file.
+ */
+EXPORT_PREFIX const CXIncludeCostEntry *clang_IncludeCostTable_getEntries(CXIncludeCostTable T);
+
+/**
+ * \brief Releases an include cost table.
+ */
+EXPORT_PREFIX void clang_IncludeCostTable_dispose(CXIncludeCostTable T);
+
+/**
+ * \brief An opaque handle to a kind-indexed cursor dispatch table.
+ */
+typedef void *CXDispatchTable;
+
+/**
+ * \brief Creates an empty dispatch table for num_rules rules.
+ */
+EXPORT_PREFIX CXDispatchTable clang_DispatchTable_create(unsigned num_rules);
+
+/**
+ * \brief Registers the interest of a rule in cursors of the given kind. For
+ * unary, binary and compound assignment operators, opcode restricts the
+ * interest to a single clang_Cursor_getUnaryOpcode/getBinaryOpcode value;
+ * pass -1 to match any cursor of that kind.
+ */
+EXPORT_PREFIX void clang_DispatchTable_addInterest(CXDispatchTable T, unsigned rule,
+                                                   enum CXCursorKind kind, int opcode);
+
+/**
+ * \brief Visits root and all its descendants once and records every cursor
+ * under each rule interested in it. Matches of a previous call are
+ * discarded. Returns the total number of matches.
+ */
+EXPORT_PREFIX unsigned clang_DispatchTable_collect(CXDispatchTable T, CXCursor root);
+
+/**
+ * \brief Same as clang_DispatchTable_collect, walking num_roots roots in
+ * order.
+ */
+EXPORT_PREFIX unsigned clang_DispatchTable_collectMany(CXDispatchTable T, const CXCursor *roots,
+                                                       unsigned num_roots);
+
+/**
+ * \brief Returns the number of cursors collected for a rule.
+ */
+EXPORT_PREFIX unsigned clang_DispatchTable_getNumMatches(CXDispatchTable T, unsigned rule);
+
+/**
+ * \brief Returns the cursors collected for a rule, in preorder.
+ */
+EXPORT_PREFIX const CXCursor *clang_DispatchTable_getMatches(CXDispatchTable T, unsigned rule);
+
+/**
+ * \brief Releases a dispatch table.
+ */
+EXPORT_PREFIX void clang_DispatchTable_dispose(CXDispatchTable T);
+
+/**
+ * \brief An opaque handle to the lazily built statement parent maps of a
+ * translation unit.
+ */
+typedef void *CXParentMap;
+
+/**
+ * \brief Creates an empty parent map cache. It must not be queried once the
+ * translation units it was used with are disposed.
+ */
+EXPORT_PREFIX CXParentMap clang_ParentMap_create(void);
+
+/**
+ * \brief Returns the parent of a statement or expression cursor, as it would
+ * appear in a cursor traversal: the enclosing statement, the VarDecl of an
+ * initializer, or the declaration owning the outermost statement. For local
+ * declarations returns their DeclStmt, for other declarations their lexical
+ * parent. Returns a null cursor at the translation unit level.
+ */
+EXPORT_PREFIX CXCursor clang_ParentMap_getParent(CXParentMap M, CXCursor C);
+
+/**
+ * \brief Returns the closest ancestor of C with the given kind, or a null
+ * cursor.
+ */
+EXPORT_PREFIX CXCursor clang_ParentMap_getEnclosing(CXParentMap M, CXCursor C, enum CXCursorKind kind);
+
+/**
+ * \brief Releases a parent map cache.
+ */
+EXPORT_PREFIX void clang_ParentMap_dispose(CXParentMap M);
+
+/**
+ * \brief An opaque handle to the macro definitions and expansions of a
+ * translation unit.
+ */
+typedef void *CXMacroIndex;
+
+/**
+ * \brief A macro definition of a macro index. Macros without a definition in
+ * the translation unit (builtins) get an entry with file set to ~0U.
+ * num_params is -1 for object-like macros and does not count an unnamed
+ * '...' parameter; is_variadic is set for variadic macros. The expansions of
+ * a definition are the num_expansions entries starting at first_expansion.
+ */
+typedef struct {
+    unsigned file;
+    unsigned line;
+    unsigned column;
+    unsigned offset;
+    int num_params;
+    unsigned is_variadic;
+    unsigned first_expansion;
+    unsigned num_expansions;
+} CXMacroDefinitionInfo;
+
+/**
+ * \brief A macro expansion of a macro index. definition is -1 when the
+ * definition record of the expanded macro is not part of the index, e.g. it
+ * was loaded from a preamble. num_args is -1 for object-like macros;
+ * produced_ast is non-zero when at least one declaration, statement or type
+ * location comes from the expansion.
+ */
+typedef struct {
+    int definition;
+    unsigned file;
+    unsigned line;
+    unsigned column;
+    unsigned offset;
+    int num_args;
+    unsigned produced_ast;
+} CXMacroExpansionInfo;
+
+/**
+ * \brief Builds the macro index of a translation unit parsed with
+ * CXTranslationUnit_DetailedPreprocessingRecord, covering every file of the
+ * translation unit. Returns NULL if there is no preprocessing record. The
+ * index must be released with clang_MacroIndex_dispose.
+ */
+EXPORT_PREFIX CXMacroIndex clang_TranslationUnit_getMacroIndex(CXTranslationUnit TU);
+
+/**
+ * \brief Returns the number of files referred to by the index.
+ */
+EXPORT_PREFIX unsigned clang_MacroIndex_getNumFiles(CXMacroIndex I);
+
+/**
+ * \brief Returns the name of the file with the given index.
+ */
+EXPORT_PREFIX CXString clang_MacroIndex_getFileName(CXMacroIndex I, unsigned index);
+
+/**
+ * \brief Returns the number of macro definitions. Definitions are sorted by
+ * macro name, then by position in the translation unit.
+ */
+EXPORT_PREFIX unsigned clang_MacroIndex_getNumDefinitions(CXMacroIndex I);
+
+/**
+ * \brief Returns the macro name of the definition with the given index.
+ */
+EXPORT_PREFIX CXString clang_MacroIndex_getDefinitionName(CXMacroIndex I, unsigned index);
+
+/**
+ * \brief Returns an array of clang_MacroIndex_getNumDefinitions() definitions.
+ */
+EXPORT_PREFIX const CXMacroDefinitionInfo *clang_MacroIndex_getDefinitions(CXMacroIndex I);
+
+/**
+ * \brief Returns the index of the first definition of the named macro, or -1.
+ * Definitions of the same macro are contiguous.
+ */
+EXPORT_PREFIX int clang_MacroIndex_findDefinition(CXMacroIndex I, const char *name);
+
+/**
+ * \brief Returns the number of macro expansions.
+ */
+EXPORT_PREFIX unsigned clang_MacroIndex_getNumExpansions(CXMacroIndex I);
+
+/**
+ * \brief Returns an array of clang_MacroIndex_getNumExpansions() expansions,
+ * grouped by definition and in source order within a definition. Expansions
+ * of unknown definitions come last.
+ */
+EXPORT_PREFIX const CXMacroExpansionInfo *clang_MacroIndex_getExpansions(CXMacroIndex I);
+
+/**
+ * \brief Releases a macro index.
+ */
+EXPORT_PREFIX void clang_MacroIndex_dispose(CXMacroIndex I);
+
+/**
+ * \brief An opaque handle to a batch of source edits on a translation unit.
+ */
+typedef void *CXRewriteBatch;
+
+/**
+ * \brief Why an edit of a batch was not applied.
+ */
+enum CXRewriteRejectionReason {
+    CXRewriteRejection_Overlap = 1,
+    CXRewriteRejection_InvalidRange = 2
+};
+
+/**
+ * \brief An edit of a batch that was not applied; edit is the position of the
+ * edit in submission order.
+ */
+typedef struct {
+    unsigned edit;
+    unsigned reason;
+} CXRewriteRejection;
+
+/**
+ * \brief Creates an empty edit batch for TU.
+ */
+EXPORT_PREFIX CXRewriteBatch clang_RewriteBatch_create(CXTranslationUnit TU);
+
+/**
+ * \brief Queues num_edits edits, each replacing the characters of ranges[i]
+ * (an empty range inserts) with texts[i]. Ranges follow libclang's
+ * convention: the end location is one past the last character.
+ */
+EXPORT_PREFIX void clang_RewriteBatch_addEdits(CXRewriteBatch B, const CXSourceRange *ranges,
+                                               const char *const *texts, unsigned num_edits);
+
+/**
+ * \brief Queues the fix-its of every warning and error of the translation
+ * unit. Fix-its attached to notes are alternatives and are skipped. Returns
+ * the number of edits queued.
+ */
+EXPORT_PREFIX unsigned clang_RewriteBatch_addFixIts(CXRewriteBatch B);
+
+/**
+ * \brief Applies the queued edits in a single pass. An edit overlapping an
+ * edit queued before it, or whose range does not lie within a single file,
+ * is rejected. Insertions at the same location are applied in submission
+ * order and identical edits are applied once. Edits in any inclusion of a
+ * header apply to that header's single buffer. Returns the number of
+ * rejected edits.
+ */
+EXPORT_PREFIX unsigned clang_RewriteBatch_apply(CXRewriteBatch B);
+
+/**
+ * \brief Returns the rejected edits of the last clang_RewriteBatch_apply.
+ */
+EXPORT_PREFIX const CXRewriteRejection *clang_RewriteBatch_getRejections(CXRewriteBatch B);
+
+/**
+ * \brief Returns the number of files modified by the last
+ * clang_RewriteBatch_apply.
+ */
+EXPORT_PREFIX unsigned clang_RewriteBatch_getNumFiles(CXRewriteBatch B);
+
+/**
+ * \brief Returns the name of a modified file.
+ */
+EXPORT_PREFIX CXString clang_RewriteBatch_getFileName(CXRewriteBatch B, unsigned index);
+
+/**
+ * \brief Returns the rewritten contents of a modified file; its size is
+ * stored in length. The buffer lives as long as the batch.
+ */
+EXPORT_PREFIX const char *clang_RewriteBatch_getBuffer(CXRewriteBatch B, unsigned index,
+                                                       unsigned *length);
+
+/**
+ * \brief Releases an edit batch.
+ */
+EXPORT_PREFIX void clang_RewriteBatch_dispose(CXRewriteBatch B);
+
+/**
+ * \brief Options of structural hashing. By default identifiers and literal
+ * values are normalized away, so that clones differing only in names or
+ * constants hash alike.
+ */
+enum CXStructuralHashFlags {
+    CXStructuralHash_None = 0x0,
+    /* Hash the names of referenced and declared entities. */
+    CXStructuralHash_Identifiers = 0x1,
+    /* Hash the values of literals. */
+    CXStructuralHash_Literals = 0x2,
+    /* Only hash bodies declared in the main file. */
+    CXStructuralHash_MainFileOnly = 0x4
+};
+
+/**
+ * \brief Returns the structural hash of a statement or expression subtree,
+ * or of the body of a function, method or block declaration; 0 for other
+ * cursors. The hash covers the statement class, operator opcodes and the
+ * shape of the subtree, and ignores implicit casts and other implicit
+ * nodes. The number of nodes hashed is stored in size when not null.
+ */
+EXPORT_PREFIX unsigned long long clang_Cursor_getStructuralHash(CXCursor C, unsigned options,
+                                                                unsigned *size);
+
+/**
+ * \brief The structural hash of a subtree; file indexes the file table of
+ * the CXSubtreeHashes or CXCloneIndex the record belongs to.
+ */
+typedef struct {
+    unsigned long long hash;
+    unsigned size;
+    unsigned kind;
+    unsigned file;
+    unsigned line;
+    unsigned column;
+    unsigned offset;
+} CXSubtreeHash;
+
+/**
+ * \brief An opaque handle to the subtree hashes of a translation unit.
+ */
+typedef void *CXSubtreeHashes;
+
+/**
+ * \brief Hashes, in one pass, every statement subtree of at least min_size
+ * nodes in the bodies of the translation unit. Records are in preorder.
+ */
+EXPORT_PREFIX CXSubtreeHashes clang_TranslationUnit_getSubtreeHashes(CXTranslationUnit TU,
+                                                                     unsigned options,
+                                                                     unsigned min_size);
+
+/**
+ * \brief Returns the number of files referred to by the records.
+ */
+EXPORT_PREFIX unsigned clang_SubtreeHashes_getNumFiles(CXSubtreeHashes H);
+
+/**
+ * \brief Returns the name of the file with the given index.
+ */
+EXPORT_PREFIX CXString clang_SubtreeHashes_getFileName(CXSubtreeHashes H, unsigned index);
+
+/**
+ * \brief Returns the number of records.
+ */
+EXPORT_PREFIX unsigned clang_SubtreeHashes_getNumRecords(CXSubtreeHashes H);
+
+/**
+ * \brief Returns the records, in preorder.
+ */
+EXPORT_PREFIX const CXSubtreeHash *clang_SubtreeHashes_getRecords(CXSubtreeHashes H);
+
+/**
+ * \brief Returns the cursor of a record. The translation unit must still be
+ * alive.
+ */
+EXPORT_PREFIX CXCursor clang_SubtreeHashes_getCursor(CXSubtreeHashes H, unsigned index);
+
+/**
+ * \brief Releases subtree hashes.
+ */
+EXPORT_PREFIX void clang_SubtreeHashes_dispose(CXSubtreeHashes H);
+
+/**
+ * \brief An opaque handle to subtree hashes merged across translation units.
+ */
+typedef void *CXCloneIndex;
+
+/**
+ * \brief A group of records sharing a hash:
+ * records[first, first + count) of clang_CloneIndex_getRecords.
+ */
+typedef struct {
+    unsigned long long hash;
+    unsigned first;
+    unsigned count;
+} CXCloneBucket;
+
+/**
+ * \brief Creates an empty clone index.
+ */
+EXPORT_PREFIX CXCloneIndex clang_CloneIndex_create(void);
+
+/**
+ * \brief Merges the records of H; the index does not reference H afterwards.
+ * A subtree seen from several translation units (e.g. in a header) is kept
+ * once.
+ */
+EXPORT_PREFIX void clang_CloneIndex_add(CXCloneIndex I, CXSubtreeHashes H);
+
+/**
+ * \brief Returns the number of files referred to by the records of the index.
+ */
+EXPORT_PREFIX unsigned clang_CloneIndex_getNumFiles(CXCloneIndex I);
+
+/**
+ * \brief Returns the name of the file with the given index.
+ */
+EXPORT_PREFIX CXString clang_CloneIndex_getFileName(CXCloneIndex I, unsigned index);
+
+/**
+ * \brief Sorts the records by hash and groups them into buckets of at least
+ * min_count records. Returns the number of buckets.
+ */
+EXPORT_PREFIX unsigned clang_CloneIndex_computeBuckets(CXCloneIndex I, unsigned min_count);
+
+/**
+ * \brief Returns the buckets of the last clang_CloneIndex_computeBuckets.
+ */
+EXPORT_PREFIX const CXCloneBucket *clang_CloneIndex_getBuckets(CXCloneIndex I);
+
+/**
+ * \brief Returns the records of the index; after
+ * clang_CloneIndex_computeBuckets they are sorted by hash.
+ */
+EXPORT_PREFIX const CXSubtreeHash *clang_CloneIndex_getRecords(CXCloneIndex I);
+
+/**
+ * \brief Returns the number of records of the index.
+ */
+EXPORT_PREFIX unsigned clang_CloneIndex_getNumRecords(CXCloneIndex I);
+
+/**
+ * \brief Releases a clone index.
+ */
+EXPORT_PREFIX void clang_CloneIndex_dispose(CXCloneIndex I);
+
+/**
+ * \brief Options of clang_Cursor_printSource. Output always uses the
+ * printer's canonical spacing, independent of the source layout.
+ */
+enum CXPrintSourceFlags {
+    CXPrintSource_None = 0x0,
+    /* Print references to non-local declarations with their fully qualified
+     * name, and types in canonical form. */
+    CXPrintSource_FullyQualified = 0x1,
+    /* Collapse the output to a single line. */
+    CXPrintSource_Compact = 0x2,
+    /* Print declarations without their bodies or initializers. */
+    CXPrintSource_Terse = 0x4
+};
+
+/**
+ * \brief Prints a statement, expression or declaration cursor with clang's
+ * printer. Works on the AST, so macro-expanded code prints as expanded.
+ * Returns an empty string for other cursors.
+ */
+EXPORT_PREFIX CXString clang_Cursor_printSource(CXCursor C, unsigned options);
+
+/**
+ * \brief An opaque handle to the output of clang_printCursors.
+ */
+typedef void *CXPrintBuffer;
+
+/**
+ * \brief Prints num_cursors cursors as clang_Cursor_printSource does, into a
+ * single buffer.
+ */
+EXPORT_PREFIX CXPrintBuffer clang_printCursors(const CXCursor *cursors, unsigned num_cursors,
+                                               unsigned options);
+
+/**
+ * \brief Returns the printed text of every cursor, concatenated; its size is
+ * stored in length.
+ */
+EXPORT_PREFIX const char *clang_PrintBuffer_getData(CXPrintBuffer B, unsigned *length);
+
+/**
+ * \brief Returns num_cursors + 1 offsets: the text of cursor i is
+ * data[offsets[i], offsets[i + 1]).
+ */
+EXPORT_PREFIX const unsigned *clang_PrintBuffer_getOffsets(CXPrintBuffer B);
+
+/**
+ * \brief Releases a print buffer.
+ */
+EXPORT_PREFIX void clang_PrintBuffer_dispose(CXPrintBuffer B);
+
+/**
+ * \brief Properties of a CXLoopInfo.
+ */
+enum CXLoopFlags {
+    /* A for loop initializing, comparing and stepping an integer induction
+     * variable. */
+    CXLoop_Canonical = 0x1,
+    CXLoop_ConstantLowerBound = 0x2,
+    CXLoop_ConstantUpperBound = 0x4,
+    CXLoop_ConstantStep = 0x8
+};
+
+/**
+ * \brief A loop of a CXLoopNest. Loops are in preorder; parent is the index
+ * of the innermost enclosing loop, or -1. For canonical loops comparison is
+ * the BinaryOperatorKind of the condition with the induction variable on
+ * the left (-1 otherwise), and the bounds and step are set when the
+ * matching flag is. The arrays subscripted in the body are
+ * clang_LoopNest_getArrays()[first_array, first_array + num_arrays).
+ */
+typedef struct {
+    unsigned kind;
+    int parent;
+    unsigned depth;
+    unsigned flags;
+    int comparison;
+    long long lower_bound;
+    long long upper_bound;
+    long long step;
+    unsigned first_array;
+    unsigned num_arrays;
+} CXLoopInfo;
+
+/**
+ * \brief Options of clang_TranslationUnit_getLoopNest.
+ */
+enum CXLoopNestFlags {
+    CXLoopNest_None = 0x0,
+    /* Only visit bodies declared in the main file. */
+    CXLoopNest_MainFileOnly = 0x1
+};
+
+/**
+ * \brief An opaque handle to the loop-nest forest of a translation unit.
+ */
+typedef void *CXLoopNest;
+
+/**
+ * \brief Collects, in one pass, every for, while, do and range-based for
+ * loop in the function, method and block bodies of the translation unit.
+ */
+EXPORT_PREFIX CXLoopNest clang_TranslationUnit_getLoopNest(CXTranslationUnit TU, unsigned options);
+
+/**
+ * \brief Returns the number of loops.
+ */
+EXPORT_PREFIX unsigned clang_LoopNest_getNumLoops(CXLoopNest N);
+
+/**
+ * \brief Returns the loops, in preorder.
+ */
+EXPORT_PREFIX const CXLoopInfo *clang_LoopNest_getLoops(CXLoopNest N);
+
+/**
+ * \brief Returns the loop statement cursors, parallel to the loops.
+ */
+EXPORT_PREFIX const CXCursor *clang_LoopNest_getCursors(CXLoopNest N);
+
+/**
+ * \brief Returns the induction variable cursors, parallel to the loops; null
+ * cursors for loops that are not canonical.
+ */
+EXPORT_PREFIX const CXCursor *clang_LoopNest_getInductionVariables(CXLoopNest N);
+
+/**
+ * \brief Returns the number of arrays and pointers subscripted in loop
+ * bodies.
+ */
+EXPORT_PREFIX unsigned clang_LoopNest_getNumArrays(CXLoopNest N);
+
+/**
+ * \brief Returns the declarations of the arrays and pointers subscripted in
+ * loop bodies, nested loops included.
+ */
+EXPORT_PREFIX const CXCursor *clang_LoopNest_getArrays(CXLoopNest N);
+
+/**
+ * \brief Releases a loop nest.
+ */
+EXPORT_PREFIX void clang_LoopNest_dispose(CXLoopNest N);
+
+/**
+ * \brief An opaque handle to a header deduplication session: the set of
+ * headers whose declarations have been handed out across translation units.
+ */
+typedef void *CXHeaderDedup;
+
+/**
+ * \brief Header and top-level declaration counts of a
+ * clang_HeaderDedup_collect call, or of all of them.
+ */
+typedef struct {
+    unsigned num_headers;
+    unsigned num_skipped_headers;
+    unsigned num_declarations;
+    unsigned num_skipped_declarations;
+} CXHeaderDedupStats;
+
+/**
+ * \brief Creates a header deduplication session with no headers seen.
+ */
+EXPORT_PREFIX CXHeaderDedup clang_HeaderDedup_create(void);
+
+/**
+ * \brief Collects the top-level declarations of TU that do not come from a
+ * header already seen in the session, then marks the headers of TU seen.
+ * Headers are identified by file, content hash and macro context: the
+ * predefined and command-line macros of the translation unit, plus the
+ * macros defined outside the header that it expands when TU has a detailed
+ * preprocessing record. Returns the number of declarations kept.
+ */
+EXPORT_PREFIX unsigned clang_HeaderDedup_collect(CXHeaderDedup D, CXTranslationUnit TU);
+
+/**
+ * \brief Returns the declarations kept by the last clang_HeaderDedup_collect,
+ * in order.
+ */
+EXPORT_PREFIX const CXCursor *clang_HeaderDedup_getCursors(CXHeaderDedup D);
+
+/**
+ * \brief Returns the counts of the last clang_HeaderDedup_collect.
+ */
+EXPORT_PREFIX CXHeaderDedupStats clang_HeaderDedup_getStats(CXHeaderDedup D);
+
+/**
+ * \brief Returns the counts summed over the session.
+ */
+EXPORT_PREFIX CXHeaderDedupStats clang_HeaderDedup_getTotals(CXHeaderDedup D);
+
+/**
+ * \brief Returns the number of distinct headers seen in the session.
+ */
+EXPORT_PREFIX unsigned clang_HeaderDedup_getNumHeaders(CXHeaderDedup D);
+
+/**
+ * \brief Releases a header deduplication session.
+ */
+EXPORT_PREFIX void clang_HeaderDedup_dispose(CXHeaderDedup D);
+
+/**
+ * \brief An opaque handle to the line index of the files of a translation
+ * unit.
+ */
+typedef void *CXLocationMap;
+
+/**
+ * \brief The expansion position of a location, as clang_getExpansionLocation
+ * would report it. file indexes the files of the CXLocationMap; it is ~0U,
+ * with all other fields 0, for invalid locations.
+ */
+typedef struct {
+    unsigned file;
+    unsigned line;
+    unsigned column;
+    unsigned offset;
+} CXLineColumn;
+
+/**
+ * \brief Which location of a cursor clang_LocationMap_mapCursors maps.
+ */
+enum CXLocationMapPosition {
+    /* clang_getCursorLocation */
+    CXLocationMap_Location = 0,
+    /* Start of clang_getCursorExtent */
+    CXLocationMap_ExtentStart = 1,
+    /* End of clang_getCursorExtent */
+    CXLocationMap_ExtentEnd = 2
+};
+
+/**
+ * \brief Creates an empty location map for TU. The line-start index of a
+ * file is built the first time one of its locations is mapped.
+ */
+EXPORT_PREFIX CXLocationMap clang_LocationMap_create(CXTranslationUnit TU);
+
+/**
+ * \brief Maps a location of each of num_cursors cursors into out, which
+ * must have room for num_cursors entries.
+ */
+EXPORT_PREFIX void clang_LocationMap_mapCursors(CXLocationMap M, const CXCursor *cursors,
+                                                unsigned num_cursors,
+                                                enum CXLocationMapPosition position,
+                                                CXLineColumn *out);
+
+/**
+ * \brief Maps num_locations source locations into out.
+ */
+EXPORT_PREFIX void clang_LocationMap_mapLocations(CXLocationMap M,
+                                                  const CXSourceLocation *locations,
+                                                  unsigned num_locations, CXLineColumn *out);
+
+/**
+ * \brief Maps num_offsets byte offsets of a file into out. Offsets past the
+ * end of the file map to invalid positions.
+ */
+EXPORT_PREFIX void clang_LocationMap_mapOffsets(CXLocationMap M, unsigned file,
+                                                const unsigned *offsets, unsigned num_offsets,
+                                                CXLineColumn *out);
+
+/**
+ * \brief Returns the id of the named file of the translation unit, or -1.
+ */
+EXPORT_PREFIX int clang_LocationMap_getFileId(CXLocationMap M, const char *name);
+
+/**
+ * \brief Returns the number of files of the map.
+ */
+EXPORT_PREFIX unsigned clang_LocationMap_getNumFiles(CXLocationMap M);
+
+/**
+ * \brief Returns the name of the file with the given id.
+ */
+EXPORT_PREFIX CXString clang_LocationMap_getFileName(CXLocationMap M, unsigned file);
+
+/**
+ * \brief Releases a location map.
+ */
+EXPORT_PREFIX void clang_LocationMap_dispose(CXLocationMap M);
+
+/**
+ * \brief A result of clang_codeCompleteTopK. typed_text, result_type and
+ * signature are offsets of NUL-terminated strings in the buffer returned by
+ * clang_TopCompletions_getStrings. score rates the match of the typed text
+ * against the prefix; higher is better.
+ */
+typedef struct {
+    unsigned kind;
+    unsigned priority;
+    unsigned availability;
+    int score;
+    unsigned typed_text;
+    unsigned result_type;
+    unsigned signature;
+} CXTopCompletionResult;
+
+/**
+ * \brief An opaque handle to the results of clang_codeCompleteTopK.
+ */
+typedef void *CXTopCompletions;
+
+/**
+ * \brief Runs clang_codeCompleteAt and keeps only the best limit results
+ * whose typed text fuzzy-matches prefix: its characters must appear in
+ * order, case-insensitively. Matches are ranked by score (prefix matches,
+ * word-boundary and consecutive matches score higher), then by clang's
+ * priority, then by typed text. Unavailable results are dropped. Only the
+ * kept results are rendered. Returns NULL if completion fails.
+ */
+EXPORT_PREFIX CXTopCompletions clang_codeCompleteTopK(CXTranslationUnit TU,
+                                                      const char *complete_filename,
+                                                      unsigned complete_line,
+                                                      unsigned complete_column,
+                                                      struct CXUnsavedFile *unsaved_files,
+                                                      unsigned num_unsaved_files,
+                                                      unsigned options, const char *prefix,
+                                                      unsigned limit);
+
+/**
+ * \brief Returns the number of results clang produced, before filtering.
+ */
+EXPORT_PREFIX unsigned clang_TopCompletions_getNumCandidates(CXTopCompletions C);
+
+/**
+ * \brief Returns the number of results kept.
+ */
+EXPORT_PREFIX unsigned clang_TopCompletions_getNumResults(CXTopCompletions C);
+
+/**
+ * \brief Returns the kept results, best first.
+ */
+EXPORT_PREFIX const CXTopCompletionResult *clang_TopCompletions_getResults(CXTopCompletions C);
+
+/**
+ * \brief Returns the string buffer of the results; its size is stored in
+ * length.
+ */
+EXPORT_PREFIX const char *clang_TopCompletions_getStrings(CXTopCompletions C, unsigned *length);
+
+/**
+ * \brief Releases the results of clang_codeCompleteTopK.
+ */
+EXPORT_PREFIX void clang_TopCompletions_dispose(CXTopCompletions C);
+
+/**
+ * \brief Properties of a CXOMPDirectiveInfo.
+ */
+enum CXOMPDirectiveFlags {
+    /* A directive without a structured block, e.g. barrier or flush. */
+    CXOMPDirective_Standalone = 0x1,
+    /* A loop directive; its associated statement is the outermost loop. */
+    CXOMPDirective_Loop = 0x2
+};
+
+/**
+ * \brief An executable OpenMP directive of a CXOMPDirectives. Directives are
+ * in preorder; parent is the index of the innermost enclosing directive, or
+ * -1. name is the offset of the NUL-terminated directive name, e.g.
+ * "parallel for", in the buffer returned by clang_OMPDirectives_getStrings.
+ * collapse is the number of loops associated with a loop directive. Its
+ * clauses are clang_OMPDirectives_getClauses()[first_clause, first_clause +
+ * num_clauses).
+ */
+typedef struct {
+    unsigned kind;
+    int parent;
+    unsigned depth;
+    unsigned flags;
+    unsigned name;
+    unsigned collapse;
+    unsigned first_clause;
+    unsigned num_clauses;
+} CXOMPDirectiveInfo;
+
+/**
+ * \brief A clause of an OpenMP directive, as written. kind is clang's
+ * OpenMPClauseKind; name and modifier are string offsets, modifier being the
+ * schedule, default, proc_bind, depend or map kind, or the reduction
+ * identifier, and empty otherwise. The variables the clause names are
+ * clang_OMPDirectives_getVariables()[first_variable, first_variable +
+ * num_variables), its integer constant arguments (collapse count, chunk
+ * size, thread count, linear step...) are
+ * clang_OMPDirectives_getArguments()[first_argument, first_argument +
+ * num_arguments).
+ */
+typedef struct {
+    unsigned kind;
+    unsigned name;
+    unsigned modifier;
+    unsigned first_variable;
+    unsigned num_variables;
+    unsigned first_argument;
+    unsigned num_arguments;
+} CXOMPClauseInfo;
+
+/**
+ * \brief Options of clang_TranslationUnit_getOMPDirectives.
+ */
+enum CXOMPDirectivesFlags {
+    CXOMPDirectives_None = 0x0,
+    /* Only visit bodies declared in the main file. */
+    CXOMPDirectives_MainFileOnly = 0x1
+};
+
+/**
+ * \brief An opaque handle to the OpenMP directives of a translation unit.
+ */
+typedef void *CXOMPDirectives;
+
+/**
+ * \brief Collects, in one pass, every executable OpenMP directive in the
+ * function, method and block bodies of the translation unit, with its
+ * clauses. Declarative directives are not included.
+ */
+EXPORT_PREFIX CXOMPDirectives clang_TranslationUnit_getOMPDirectives(CXTranslationUnit TU,
+                                                                     unsigned options);
+
+/**
+ * \brief Returns the number of directives.
+ */
+EXPORT_PREFIX unsigned clang_OMPDirectives_getNumDirectives(CXOMPDirectives D);
+
+/**
+ * \brief Returns the directives, in preorder.
+ */
+EXPORT_PREFIX const CXOMPDirectiveInfo *clang_OMPDirectives_getDirectives(CXOMPDirectives D);
+
+/**
+ * \brief Returns the directive cursors, parallel to the directives.
+ */
+EXPORT_PREFIX const CXCursor *clang_OMPDirectives_getCursors(CXOMPDirectives D);
+
+/**
+ * \brief Returns the associated statements, parallel to the directives: the
+ * outermost loop of loop directives, the structured block of the others, and
+ * null cursors for standalone directives.
+ */
+EXPORT_PREFIX const CXCursor *clang_OMPDirectives_getAssociated(CXOMPDirectives D);
+
+/**
+ * \brief Returns the number of clauses of all the directives.
+ */
+EXPORT_PREFIX unsigned clang_OMPDirectives_getNumClauses(CXOMPDirectives D);
+
+/**
+ * \brief Returns the clauses of all the directives; each directive refers to
+ * a range of them.
+ */
+EXPORT_PREFIX const CXOMPClauseInfo *clang_OMPDirectives_getClauses(CXOMPDirectives D);
+
+/**
+ * \brief Returns the number of variables named by clauses.
+ */
+EXPORT_PREFIX unsigned clang_OMPDirectives_getNumVariables(CXOMPDirectives D);
+
+/**
+ * \brief Returns the declarations of the variables named by clauses.
+ */
+EXPORT_PREFIX const CXCursor *clang_OMPDirectives_getVariables(CXOMPDirectives D);
+
+/**
+ * \brief Returns the number of integer clause arguments.
+ */
+EXPORT_PREFIX unsigned clang_OMPDirectives_getNumArguments(CXOMPDirectives D);
+
+/**
+ * \brief Returns the integer clause arguments; each clause refers to a range
+ * of them.
+ */
+EXPORT_PREFIX const long long *clang_OMPDirectives_getArguments(CXOMPDirectives D);
+
+/**
+ * \brief Returns the string buffer of the directives and clauses; its size
+ * is stored in length.
+ */
+EXPORT_PREFIX const char *clang_OMPDirectives_getStrings(CXOMPDirectives D, unsigned *length);
+
+/**
+ * \brief Releases the OpenMP directives of a translation unit.
+ */
+EXPORT_PREFIX void clang_OMPDirectives_dispose(CXOMPDirectives D);
 
 #ifdef __cplusplus
 }
@@ -55,9 +55,9 @@ llvm_ldflags = (
 )
 
 if ctypes.util.find_library('clang-cpp'):
-    libraries = ['clang-cpp']
+    libraries = ['clang-cpp', 'clang']
 else:
-    libraries=["clangAST", "clangBasic", "clangLex", "libclang", "LLVMBinaryFormat", "LLVMBitstreamReader", "LLVMCore", "LLVMFrontendOpenMP", "LLVMRemarks", "LLVMSupport"],
+    libraries=["clangFrontend", "clangDriver", "clangSerialization", "clangParse", "clangSema", "clangAnalysis", "clangRewrite", "clangEdit", "clangAST", "clangBasic", "clangLex", "libclang", "LLVMBinaryFormat", "LLVMBitstreamReader", "LLVMCore", "LLVMFrontendOpenMP", "LLVMOption", "LLVMRemarks", "LLVMSupport"]
 
 setup(
     name="sealang",
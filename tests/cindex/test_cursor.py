@@ -755,3 +755,18 @@ class TestCursor(unittest.TestCase):
         # [c-index-test handles this by running the source through clang, emitting
         #  an AST file and running libclang on that AST file]
         self.assertIn(foo.mangled_name, ('_Z3fooii', '__Z3fooii', '?foo@@YAHHH', '?foo@@YAHHH@Z'))
+
+    def test_compact_cursor(self):
+        tu = get_tu('int foo(int a) { return a + 1; }')
+        foo = get_cursor(tu, 'foo')
+        self.assertFalse(hasattr(foo, '__dict__'))
+        with self.assertRaises(AttributeError):
+            foo.cached_value = 1
+
+        # Cached and uncached properties keep working through the slots.
+        self.assertEqual(foo.spelling, 'foo')
+        self.assertIs(foo.spelling, foo.spelling)
+        self.assertEqual(foo.extent.start.line, 1)
+        self.assertEqual(foo.semantic_parent, tu.cursor)
+        for child in foo.walk_preorder():
+            self.assertIs(child.translation_unit, tu)
@@ -0,0 +1,67 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CursorKind
+from clang.cindex import HeaderDedup
+from clang.cindex import Rule
+from clang.cindex import RuleEngine
+from clang.cindex import TranslationUnit
+
+import unittest
+
+
+kHeader = """\
+int shared(int);
+struct point { int x, y; };
+"""
+
+
+def parse(name, body, args=()):
+    return TranslationUnit.from_source(name, ['-Iinclude'] + list(args), unsaved_files=[
+        (name, '#include "common.h"\n' + body),
+        ('include/common.h', kHeader),
+    ])
+
+
+class FunctionNames(Rule):
+    kinds = [CursorKind.FUNCTION_DECL]
+
+    def visit(self, cursor):
+        return cursor.spelling
+
+
+class TestHeaderDedup(unittest.TestCase):
+    def test_skip_seen_header(self):
+        dedup = HeaderDedup()
+
+        first = dedup.get_children(parse('a.c', 'int a(void);\n'))
+        self.assertEqual([c.spelling for c in first], ['shared', 'point', 'a'])
+        self.assertEqual((dedup.stats.num_headers, dedup.stats.num_skipped_headers), (1, 0))
+
+        second = dedup.get_children(parse('b.c', 'int b(void);\n'))
+        self.assertEqual([c.spelling for c in second], ['b'])
+        self.assertEqual((dedup.stats.num_headers, dedup.stats.num_skipped_headers), (1, 1))
+        self.assertEqual(dedup.stats.num_skipped_declarations, 2)
+
+        self.assertEqual(dedup.num_headers, 1)
+        self.assertEqual(dedup.totals.num_declarations, 4)
+        self.assertEqual(dedup.totals.num_skipped_declarations, 2)
+
+    def test_macro_context(self):
+        dedup = HeaderDedup()
+        dedup.get_children(parse('a.c', ''))
+        children = dedup.get_children(parse('b.c', '', ['-DCONFIG=1']))
+
+        self.assertEqual(len(children), 2)
+        self.assertEqual(dedup.num_headers, 2)
+
+    def test_walk_and_rules(self):
+        dedup = HeaderDedup()
+        kinds = [c.kind for c in dedup.walk_preorder(parse('a.c', ''))]
+        self.assertEqual(kinds.count(CursorKind.FIELD_DECL), 2)
+
+        rule = FunctionNames()
+        results = RuleEngine([rule]).run(parse('b.c', 'int b(void);\n'), dedup=dedup)
+        self.assertEqual(results[rule], ['b'])
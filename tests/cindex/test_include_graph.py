@@ -0,0 +1,102 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import IncludeCostTable
+from clang.cindex import IncludeGraph
+from clang.cindex import TranslationUnit
+
+import unittest
+
+
+kInputsDir = os.path.join(os.path.dirname(__file__), 'INPUTS')
+
+
+class TestIncludeGraph(unittest.TestCase):
+    def assert_graph(self, graph, src):
+        names = [os.path.basename(name) for name in graph.files]
+        self.assertEqual(sorted(names),
+                         ['header1.h', 'header2.h', 'header3.h', 'include.cpp'])
+        self.assertEqual(os.path.normpath(graph.files[0]), os.path.normpath(src))
+        self.assertEqual(graph.stats[0].depth, 0)
+        self.assertEqual(graph.stats[names.index('header1.h')].depth, 1)
+        self.assertEqual(graph.stats[names.index('header3.h')].depth, 2)
+
+        edges = [(names[e.includer], names[e.included], e.line) for e in graph.edges]
+        self.assertIn(('include.cpp', 'header1.h', 1), edges)
+        self.assertIn(('include.cpp', 'header2.h', 2), edges)
+        self.assertIn(('header1.h', 'header3.h', 4), edges)
+        self.assertIn(('header2.h', 'header3.h', 4), edges)
+        return names
+
+    def test_translation_unit_graph(self):
+        src = os.path.join(kInputsDir, 'include.cpp')
+        tu = TranslationUnit.from_source(src)
+        self.assert_graph(tu.get_include_graph(), src)
+
+    def test_translation_unit_graph_matches_profile(self):
+        src = os.path.join(kInputsDir, 'include.cpp')
+        tu = TranslationUnit.from_source(
+            src, options=TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD)
+
+        def edges(graph):
+            names = [os.path.basename(name) for name in graph.files]
+            return [(names[e.includer], names[e.included], e.line, e.column)
+                    for e in graph.edges]
+
+        graph = tu.get_include_graph()
+        self.assert_graph(graph, src)
+        self.assertIn(('include.cpp', 'header1.h', 3, 10), edges(graph))
+        self.assertEqual(edges(graph), edges(IncludeGraph.profile(src)))
+
+    def test_profile(self):
+        src = os.path.join(kInputsDir, 'include.cpp')
+        graph = IncludeGraph.profile(src)
+        names = self.assert_graph(graph, src)
+
+        # header1.h is included twice but guarded; header3.h is not guarded.
+        self.assertIn(('include.cpp', 'header1.h', 3),
+                      [(names[e.includer], names[e.included], e.line) for e in graph.edges])
+        self.assertEqual(graph.stats[names.index('header1.h')].num_entries, 1)
+        self.assertEqual(graph.stats[names.index('header3.h')].num_entries, 2)
+
+        # 'void f();' twice, 'int main() { }' once.
+        self.assertEqual(graph.stats[names.index('header3.h')].num_tokens, 10)
+        self.assertEqual(graph.stats[0].num_tokens, 6)
+        for stats in graph.stats:
+            self.assertGreaterEqual(stats.total_time, stats.self_time)
+
+    def test_profile_unsaved(self):
+        graph = IncludeGraph.profile('fake.c', ['-Iincludes'], unsaved_files=[
+            ('fake.c', '#include "fake.h"\nint x = X;\n'),
+            ('includes/fake.h', '#define X 1\n'),
+        ])
+        names = [os.path.basename(name) for name in graph.files]
+        self.assertEqual(names, ['fake.c', 'fake.h'])
+        self.assertEqual(len(graph.edges), 1)
+
+    def test_profile_unsaved_non_ascii(self):
+        graph = IncludeGraph.profile('fake.c', unsaved_files=[
+            ('fake.c', '// é\nint x = 1;\n'),
+        ])
+        # The whole UTF-8 buffer is parsed, up to the final ';'.
+        self.assertEqual(graph.stats[0].num_tokens, 5)
+
+    def test_cost_table(self):
+        src = os.path.join(kInputsDir, 'include.cpp')
+        table = IncludeCostTable()
+        table.add(IncludeGraph.profile(src))
+        table.add(IncludeGraph.profile(src))
+        self.assertEqual(len(table), 4)
+
+        entries = dict((os.path.basename(name), entry)
+                       for name, entry in table.ranking())
+        self.assertEqual(entries['header3.h'].num_translation_units, 2)
+        self.assertEqual(entries['header3.h'].num_includes, 4)
+        self.assertEqual(entries['header1.h'].num_includes, 4)
+        self.assertEqual(entries['header3.h'].num_tokens, 20)
+
+        ranked = table.ranking(key='num_tokens', limit=1)
+        self.assertEqual(len(ranked), 1)
+        self.assertEqual(os.path.basename(ranked[0][0]), 'header3.h')
@@ -0,0 +1,73 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import LocationMap
+from clang.cindex import TranslationUnit
+
+import unittest
+from .util import get_tu
+
+
+kSource = """\
+int one;
+#define DECLARE(name) int name
+  DECLARE(two);
+struct s {
+    int three;
+};
+"""
+
+
+class TestLocationMap(unittest.TestCase):
+    def test_cursors(self):
+        tu = get_tu(kSource)
+        cursors = list(tu.cursor.walk_preorder())[1:]
+        locations = LocationMap(tu)
+
+        mapped = locations.map_cursors(cursors)
+        self.assertEqual(locations.files, ['t.c'])
+        for cursor, position in zip(cursors, mapped):
+            self.assertEqual(
+                (position.line, position.column, position.offset),
+                (cursor.location.line, cursor.location.column, cursor.location.offset),
+            )
+
+        for which, attribute in ((LocationMap.EXTENT_START, 'start'),
+                                 (LocationMap.EXTENT_END, 'end')):
+            mapped = locations.map_cursors(cursors, which)
+            for cursor, position in zip(cursors, mapped):
+                location = getattr(cursor.extent, attribute)
+                self.assertEqual((position.line, position.column),
+                                 (location.line, location.column))
+
+    def test_locations(self):
+        tu = get_tu(kSource)
+        locations = LocationMap(tu)
+        mapped = locations.map_locations([tu.get_location('t.c', 30), tu.cursor.location])
+
+        self.assertEqual((mapped[0].line, mapped[0].column), (2, 22))
+        self.assertEqual(mapped[1].file, LocationMap.INVALID_FILE)
+
+    def test_offsets_line_endings(self):
+        source = 'int a;\r\nint b;\rint c;\n\nint d;\n\rint e;'
+        tu = TranslationUnit.from_source('t.c', unsaved_files=[('t.c', source)])
+        locations = LocationMap(tu)
+
+        offsets = [source.index(name) for name in 'abcde']
+        mapped = locations.map_offsets('t.c', offsets)
+        self.assertEqual([(p.line, p.column) for p in mapped],
+                         [(1, 5), (2, 5), (3, 5), (5, 5), (6, 5)])
+        for name, position in zip('abcde', mapped):
+            self.assertEqual(position.line, tu.get_location('t.c', source.index(name)).line)
+
+    def test_offsets_out_of_range(self):
+        source = 'int a;\n'
+        tu = TranslationUnit.from_source('t.c', unsaved_files=[('t.c', source)])
+        locations = LocationMap(tu)
+
+        end, past = locations.map_offsets('t.c', [len(source), len(source) + 1])
+        self.assertEqual((end.line, end.column), (2, 1))
+        self.assertEqual(past.file, LocationMap.INVALID_FILE)
+        self.assertEqual(locations.get_file_id('missing.c'), None)
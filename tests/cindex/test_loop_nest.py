@@ -0,0 +1,110 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import BinaryOperator
+from clang.cindex import CursorKind
+
+import unittest
+from .util import get_tu
+
+
+kSource = """\
+#define N 16
+int grid[N][N];
+
+void f(int *out, int n) {
+    for (int i = 0; i < N; ++i)
+        for (int j = N - 1; 0 <= j; j -= 2)
+            out[i] += grid[i][j];
+
+    int k;
+    for (k = n; k > 0; k = k - 4)
+        out[k] = 0;
+
+    while (n--)
+        do { n /= 2; } while (n > 8);
+
+    for (int p = 0; p * p < n; p++) {}
+}
+"""
+
+
+class TestLoopNest(unittest.TestCase):
+    def get_loops(self):
+        tu = get_tu(kSource)
+        return tu.get_loop_nest().loops
+
+    def test_forest(self):
+        loops = self.get_loops()
+
+        self.assertEqual([(l.kind, l.depth, l.parent) for l in loops], [
+            (CursorKind.FOR_STMT, 0, None),
+            (CursorKind.FOR_STMT, 1, 0),
+            (CursorKind.FOR_STMT, 0, None),
+            (CursorKind.WHILE_STMT, 0, None),
+            (CursorKind.DO_STMT, 1, 3),
+            (CursorKind.FOR_STMT, 0, None),
+        ])
+        self.assertEqual(loops[0].children, [1])
+        self.assertEqual(loops[3].children, [4])
+
+    def test_canonical(self):
+        outer, inner, down = self.get_loops()[:3]
+
+        self.assertTrue(outer.is_canonical)
+        self.assertEqual(outer.induction_variable.spelling, 'i')
+        self.assertEqual((outer.lower_bound, outer.upper_bound, outer.step),
+                         (0, 16, 1))
+        self.assertEqual(outer.comparison, BinaryOperator.LT)
+
+        # Reversed condition and compound step.
+        self.assertEqual(inner.comparison, BinaryOperator.GE)
+        self.assertEqual((inner.lower_bound, inner.upper_bound, inner.step),
+                         (15, 0, -2))
+
+        # Assignment init, non-constant lower bound.
+        self.assertEqual(down.induction_variable.spelling, 'k')
+        self.assertEqual((down.lower_bound, down.upper_bound, down.step),
+                         (None, 0, -4))
+        self.assertEqual(down.comparison, BinaryOperator.GT)
+
+    def test_not_canonical(self):
+        loops = self.get_loops()
+        for loop in loops[3:]:
+            self.assertFalse(loop.is_canonical)
+            self.assertIsNone(loop.induction_variable)
+            self.assertIsNone(loop.comparison)
+            self.assertIsNone(loop.step)
+
+    def test_arrays(self):
+        outer, inner, down = self.get_loops()[:3]
+
+        self.assertEqual([a.spelling for a in outer.arrays], ['out', 'grid'])
+        self.assertEqual([a.spelling for a in inner.arrays], ['out', 'grid'])
+        self.assertEqual([a.spelling for a in down.arrays], ['out'])
+        self.assertEqual(outer.arrays[1].kind, CursorKind.VAR_DECL)
+
+    def test_openmp(self):
+        tu = get_tu("""\
+void scale(double *a, int n) {
+#pragma omp parallel for collapse(2)
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            a[i * n + j] *= 2;
+
+#pragma omp parallel
+    {
+#pragma omp for
+        for (int k = 0; k < n; ++k)
+            a[k] = 0;
+    }
+}
+""", flags=['-fopenmp'])
+        loops = tu.get_loop_nest().loops
+
+        self.assertEqual([(l.cursor.location.line, l.depth) for l in loops],
+                         [(3, 0), (4, 1), (10, 0)])
+        self.assertEqual(loops[0].induction_variable.spelling, 'i')
+        self.assertEqual([v.spelling for v in loops[2].arrays], ['a'])
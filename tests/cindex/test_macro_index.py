@@ -0,0 +1,88 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import TranslationUnit
+
+import unittest
+
+
+kHeader = """\
+#define SQUARE(x) ((x) * (x))
+#define UNUSED_FLAG 1
+"""
+
+kSource = """\
+#include "macros.h"
+#define LOG(fmt, ...) log_impl(fmt, __VA_ARGS__)
+#define TRACE(args...) log_impl(args)
+#define NOTHING
+
+void log_impl(const char *, ...);
+
+int f(int a) {
+    NOTHING
+    LOG("%d %d", SQUARE(a), 2);
+    return SQUARE(a + 1);
+}
+"""
+
+
+class TestMacroIndex(unittest.TestCase):
+    def get_index(self, options=TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD):
+        tu = TranslationUnit.from_source('t.c', ['-Iinclude'], unsaved_files=[
+            ('t.c', kSource),
+            ('include/macros.h', kHeader),
+        ], options=options)
+        return tu.get_macro_index()
+
+    def test_requires_processing_record(self):
+        self.assertIsNone(self.get_index(options=0))
+
+    def test_definitions(self):
+        index = self.get_index()
+        self.assertEqual(index.names, sorted(index.names))
+
+        square, = index.find('SQUARE')
+        definition = index.definitions[square]
+        self.assertEqual(definition.num_params, 1)
+        self.assertEqual(definition.num_expansions, 2)
+        self.assertTrue(index.files[definition.file].endswith('macros.h'))
+        self.assertEqual(definition.line, 1)
+
+        log, = index.find('LOG')
+        self.assertEqual(index.definitions[log].num_params, 1)
+        self.assertTrue(index.definitions[log].is_variadic)
+
+        # A named variadic parameter is counted.
+        trace, = index.find('TRACE')
+        self.assertEqual(index.definitions[trace].num_params, 1)
+        self.assertTrue(index.definitions[trace].is_variadic)
+
+        nothing, = index.find('NOTHING')
+        self.assertEqual(index.definitions[nothing].num_params, -1)
+
+        self.assertEqual(index.find('UNDEFINED_MACRO'), [])
+        unused, = index.find('UNUSED_FLAG')
+        self.assertEqual(index.definitions[unused].num_expansions, 0)
+
+    def test_expansions(self):
+        index = self.get_index()
+
+        expansions = index.get_expansions('SQUARE')
+        self.assertEqual([e.line for e in expansions], [10, 11])
+        self.assertEqual([e.num_args for e in expansions], [1, 1])
+        self.assertTrue(all(e.produced_ast for e in expansions))
+        self.assertTrue(index.files[expansions[0].file].endswith('t.c'))
+
+        log, = index.get_expansions('LOG')
+        self.assertEqual(log.num_args, 3)
+        self.assertEqual(log.column, 5)
+
+        nothing, = index.get_expansions('NOTHING')
+        self.assertEqual(nothing.num_args, -1)
+        self.assertFalse(nothing.produced_ast)
+
+        # Every expansion of this unit has a known definition.
+        self.assertTrue(all(e.definition >= 0 for e in index.expansions))
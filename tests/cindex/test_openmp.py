@@ -0,0 +1,93 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CursorKind
+
+import unittest
+from .util import get_tu
+
+
+kSource = """\
+#define N 64
+
+void f(double *a, double *b, int n) {
+    double sum = 0;
+    int i, j;
+#pragma omp parallel for collapse(2) schedule(dynamic, 4) private(j) reduction(+:sum)
+    for (i = 0; i < N; ++i)
+        for (j = 0; j < N; ++j)
+            sum += a[i * N + j];
+
+#pragma omp parallel shared(a, b) num_threads(8)
+    {
+#pragma omp for
+        for (int k = 0; k < n; ++k)
+            b[k] = a[k];
+#pragma omp barrier
+    }
+}
+"""
+
+
+class TestOpenMP(unittest.TestCase):
+    def get_tu(self):
+        return get_tu(kSource, flags=['-fopenmp'])
+
+    def test_directives(self):
+        directives = self.get_tu().get_openmp_directives().directives
+
+        self.assertEqual([(d.kind, d.name, d.depth, d.parent) for d in directives], [
+            (CursorKind.OMP_PARALLEL_FOR_DIRECTIVE, 'parallel for', 0, None),
+            (CursorKind.OMP_PARALLEL_DIRECTIVE, 'parallel', 0, None),
+            (CursorKind.OMP_FOR_DIRECTIVE, 'for', 1, 1),
+            (CursorKind.OMP_BARRIER_DIRECTIVE, 'barrier', 1, 1),
+        ])
+        self.assertEqual(directives[1].children, [2, 3])
+        self.assertEqual(directives[0].cursor.location.line, 6)
+
+    def test_clauses(self):
+        parallel_for, parallel = self.get_tu().get_openmp_directives().roots
+
+        self.assertEqual([c.name for c in parallel_for.clauses],
+                         ['collapse', 'schedule', 'private', 'reduction'])
+        self.assertEqual(parallel_for.get_clause('collapse').arguments, [2])
+        schedule = parallel_for.get_clause('schedule')
+        self.assertEqual((schedule.modifier, schedule.arguments), ('dynamic', [4]))
+        self.assertEqual(
+            [v.spelling for v in parallel_for.get_clause('private').variables], ['j'])
+        reduction = parallel_for.get_clause('reduction')
+        self.assertEqual(reduction.modifier, '+')
+        self.assertEqual([v.spelling for v in reduction.variables], ['sum'])
+        self.assertEqual(reduction.variables[0].kind, CursorKind.VAR_DECL)
+
+        self.assertEqual(
+            [v.spelling for v in parallel.get_clause('shared').variables], ['a', 'b'])
+        self.assertEqual(parallel.get_clause('num_threads').arguments, [8])
+        self.assertIsNone(parallel.get_clause('collapse'))
+
+    def test_associated(self):
+        tu = self.get_tu()
+        parallel_for, parallel, inner, barrier = tu.get_openmp_directives().directives
+
+        self.assertTrue(parallel_for.is_loop)
+        self.assertEqual(parallel_for.collapse, 2)
+        self.assertEqual(parallel_for.associated.kind, CursorKind.FOR_STMT)
+        self.assertEqual(parallel_for.associated.location.line, 7)
+        self.assertEqual(inner.collapse, 1)
+        self.assertEqual(inner.associated.location.line, 14)
+
+        # Loop directives link to the loop nest.
+        loops = tu.get_loop_nest().loops
+        self.assertEqual(parallel_for.associated, loops[0].cursor)
+        self.assertEqual(inner.associated, loops[2].cursor)
+
+        self.assertFalse(parallel.is_loop)
+        self.assertEqual(parallel.associated.kind, CursorKind.COMPOUND_STMT)
+        self.assertTrue(barrier.is_standalone)
+        self.assertIsNone(barrier.associated)
+
+    def test_no_openmp(self):
+        tu = get_tu('void f(void) {}')
+        self.assertEqual(len(tu.get_openmp_directives()), 0)
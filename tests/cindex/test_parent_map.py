@@ -0,0 +1,64 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CursorKind
+
+from .util import get_cursor, get_tu
+
+import unittest
+
+
+kInput = """\
+int g(int);
+
+int f(int n) {
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+        while (total < 100)
+            total += g(i);
+    }
+    return total;
+}
+"""
+
+
+class TestParentMap(unittest.TestCase):
+    def test_parent_matches_traversal(self):
+        tu = get_tu(kInput)
+        f = get_cursor(tu, 'f')
+        for cursor in f.walk_preorder():
+            for child in cursor.get_children():
+                self.assertEqual(child.parent, cursor)
+
+    def test_enclosing(self):
+        tu = get_tu(kInput)
+        call = next(c for c in tu.cursor.walk_preorder()
+                    if c.kind == CursorKind.CALL_EXPR)
+
+        loop = call.enclosing(CursorKind.WHILE_STMT)
+        self.assertIsNotNone(loop)
+        self.assertEqual(loop.kind, CursorKind.WHILE_STMT)
+        self.assertEqual(call.enclosing(CursorKind.FOR_STMT).kind,
+                         CursorKind.FOR_STMT)
+        self.assertEqual(call.enclosing(CursorKind.FUNCTION_DECL).spelling, 'f')
+        self.assertIsNone(call.enclosing(CursorKind.IF_STMT))
+
+    def test_ancestors(self):
+        tu = get_tu(kInput)
+        call = next(c for c in tu.cursor.walk_preorder()
+                    if c.kind == CursorKind.CALL_EXPR)
+        kinds = [c.kind for c in call.get_ancestors()]
+        self.assertEqual(kinds[-2:], [CursorKind.FUNCTION_DECL,
+                                      CursorKind.TRANSLATION_UNIT])
+        self.assertIn(CursorKind.COMPOUND_ASSIGNMENT_OPERATOR, kinds)
+
+    def test_initializer_parent(self):
+        tu = get_tu(kInput)
+        total = get_cursor(tu, 'total')
+        self.assertEqual(total.kind, CursorKind.VAR_DECL)
+        self.assertEqual(total.parent.kind, CursorKind.DECL_STMT)
+
+        init = next(total.get_children())
+        self.assertEqual(init.parent, total)
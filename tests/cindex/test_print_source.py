@@ -0,0 +1,59 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import Cursor
+from clang.cindex import CursorKind
+
+import unittest
+from .util import get_cursor
+from .util import get_tu
+
+
+kSource = """\
+#define TWICE(x) ((x)+(x))
+namespace ns {
+int limit;
+int scale(int v) {
+    int r = TWICE(v)*limit;
+    return r   +   1;
+}
+}
+"""
+
+
+class TestPrintSource(unittest.TestCase):
+    def get_statements(self):
+        tu = get_tu(kSource, lang='cpp')
+        scale = get_cursor(tu, 'scale')
+        body = next(c for c in scale.get_children()
+                    if c.kind == CursorKind.COMPOUND_STMT)
+        return scale, list(body.get_children())
+
+    def test_expression(self):
+        _, (decl, ret) = self.get_statements()
+        value = next(ret.get_children())
+
+        self.assertEqual(value.print_source(), 'r + 1')
+        self.assertEqual(decl.print_source(compact=True),
+                         'int r = ((v) + (v)) * limit;')
+
+    def test_qualified(self):
+        _, (decl, _) = self.get_statements()
+        self.assertEqual(decl.print_source(qualified=True, compact=True),
+                         'int r = ((v) + (v)) * ns::limit;')
+
+    def test_declaration(self):
+        scale, _ = self.get_statements()
+        self.assertEqual(scale.print_source(terse=True), 'int scale(int v)')
+        self.assertTrue(scale.print_source().startswith('int scale(int v) {\n'))
+
+    def test_bulk(self):
+        scale, statements = self.get_statements()
+        cursors = [scale] + statements + [scale.translation_unit.cursor]
+
+        texts = Cursor.print_sources(cursors, compact=True)
+        self.assertEqual(texts, [c.print_source(compact=True) for c in cursors])
+        self.assertEqual(texts[-1], '')
+        self.assertEqual(Cursor.print_sources([]), [])
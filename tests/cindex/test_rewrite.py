@@ -0,0 +1,115 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CursorKind
+from clang.cindex import RewriteBatch
+from clang.cindex import SourceLocation
+from clang.cindex import SourceRange
+from clang.cindex import TranslationUnit
+
+import unittest
+from .util import get_cursor
+from .util import get_tu
+
+
+kSource = """\
+int sum(int a, int b) {
+    return a + b; // é
+}
+"""
+
+
+class TestRewriteBatch(unittest.TestCase):
+    def test_replace_and_insert(self):
+        tu = get_tu(kSource)
+        f = get_cursor(tu, 'sum')
+        a, b = [c for c in f.get_arguments()]
+
+        batch = RewriteBatch(tu)
+        batch.add_edits([(a, 'long x'), (b, 'long y')])
+        batch.insert(f.extent.start, 'static ')
+        buffers = batch.apply()
+
+        self.assertEqual(batch.rejections, [])
+        self.assertEqual(list(buffers), ['t.c'])
+        self.assertEqual(buffers['t.c'], kSource.replace(
+            'int sum(int a, int b)', 'static int sum(long x, long y)'))
+
+    def test_overlap(self):
+        tu = get_tu(kSource)
+        f = get_cursor(tu, 'sum')
+        ret = next(c for c in f.walk_preorder()
+                   if c.kind == CursorKind.RETURN_STMT)
+        expr = next(ret.get_children())
+
+        batch = RewriteBatch(tu)
+        batch.replace(ret, 'return 0')
+        batch.replace(expr, 'a - b')
+        batch.replace(ret, 'return 0')
+        buffers = batch.apply()
+
+        self.assertEqual([(r.edit, r.reason) for r in batch.rejections],
+                         [(1, RewriteBatch.OVERLAP)])
+        self.assertIn('    return 0; // é\n', buffers['t.c'])
+
+    def test_insertion_inside_replacement(self):
+        tu = get_tu(kSource)
+        f = tu.get_file('t.c')
+
+        def location(offset):
+            return SourceLocation.from_offset(tu, f, offset)
+
+        batch = RewriteBatch(tu)
+        batch.replace(SourceRange.from_locations(location(5), location(10)), 'X')
+        batch.insert(location(5), '<')
+        batch.insert(location(7), '!')
+        buffers = batch.apply()
+
+        self.assertEqual([(r.edit, r.reason) for r in batch.rejections],
+                         [(2, RewriteBatch.OVERLAP)])
+        self.assertNotIn('!', buffers['t.c'])
+
+    def test_header_included_twice(self):
+        tu = TranslationUnit.from_source('t.c', unsaved_files=[
+            ('t.c', '#include "twice.h"\n#include "twice.h"\n'
+                    'int main(void) { return counter; }\n'),
+            ('twice.h', 'int counter;\n'),
+        ])
+        counters = [c for c in tu.cursor.get_children() if c.spelling == 'counter']
+        self.assertEqual(len(counters), 2)
+
+        batch = RewriteBatch(tu)
+        batch.add_edits((c, 'long counter') for c in counters)
+        buffers = batch.apply()
+
+        self.assertEqual(batch.rejections, [])
+        (name, contents), = buffers.items()
+        self.assertTrue(name.endswith('twice.h'))
+        self.assertEqual(contents, 'long counter;\n')
+
+    def test_insertions_keep_order(self):
+        tu = get_tu(kSource)
+        f = get_cursor(tu, 'sum')
+        end = f.extent.end
+
+        batch = RewriteBatch(tu)
+        batch.insert(end, '\n// one')
+        batch.insert(end, '\n// two')
+        buffers = batch.apply()
+
+        self.assertTrue(buffers['t.c'].endswith('}\n// one\n// two\n'))
+
+    def test_no_edits(self):
+        batch = RewriteBatch(get_tu(kSource))
+        self.assertEqual(batch.apply(), {})
+
+    def test_fixits(self):
+        tu = get_tu('struct S { int x; };\nint f(struct S *s) { return s.x; }\n')
+        batch = RewriteBatch(tu)
+
+        self.assertEqual(batch.add_fixits(), 1)
+        buffers = batch.apply()
+        self.assertEqual(buffers['t.c'],
+                         'struct S { int x; };\nint f(struct S *s) { return s->x; }\n')
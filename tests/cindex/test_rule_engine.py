@@ -0,0 +1,79 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import BinaryOperator
+from clang.cindex import CursorKind
+from clang.cindex import Rule
+from clang.cindex import RuleEngine
+from clang.cindex import UnaryOperator
+
+from .util import get_tu
+
+import unittest
+
+
+kInput = """\
+int g(int);
+
+int f(int a, int b) {
+    int c = a + b;
+    c += a * b;
+    c = -c;
+    for (int i = 0; i < a; ++i)
+        c = c + g(i);
+    return c;
+}
+"""
+
+
+class CallRule(Rule):
+    kinds = (CursorKind.CALL_EXPR,)
+
+    def visit(self, cursor):
+        return cursor.spelling
+
+
+class AdditionRule(Rule):
+    operators = (BinaryOperator.ADD, BinaryOperator.ADDASSIGN)
+
+    def visit(self, cursor):
+        return cursor.operator
+
+
+class NegationRule(Rule):
+    kinds = (CursorKind.UNARY_OPERATOR,)
+    operators = (UnaryOperator.MINUS,)
+
+    def check(self, cursors):
+        return [c.unary_operator for c in cursors]
+
+
+class TestRuleEngine(unittest.TestCase):
+    def test_dispatch(self):
+        tu = get_tu(kInput)
+        rules = [CallRule(), AdditionRule(), NegationRule()]
+        results = RuleEngine(rules).run(tu)
+
+        self.assertEqual(results[rules[0]], ['g'])
+        self.assertEqual(results[rules[1]], ['+', '+=', '+'])
+        # The kind interest already covers '-'; it must not be reported twice.
+        self.assertEqual(results[rules[2]],
+                         [UnaryOperator.MINUS, UnaryOperator.PREINC])
+
+    def test_matches_keep_translation_unit(self):
+        tu = get_tu(kInput)
+        engine = RuleEngine([CallRule()])
+        engine.table.collect(tu.cursor)
+        matches = engine.table.get_matches(0)
+        self.assertEqual(len(matches), 1)
+        self.assertIs(matches[0].translation_unit, tu)
+        self.assertEqual(matches[0].kind, CursorKind.CALL_EXPR)
+
+    def test_rerun(self):
+        engine = RuleEngine([CallRule()])
+        tu = get_tu(kInput)
+        first = engine.run(tu)
+        second = engine.run(tu.cursor)
+        self.assertEqual(list(first.values()), list(second.values()))
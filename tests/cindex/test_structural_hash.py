@@ -0,0 +1,91 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CloneIndex
+from clang.cindex import CursorKind
+
+import unittest
+from .util import get_cursor
+from .util import get_tu
+
+
+kSource = """\
+int total(int *values, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += values[i];
+    return sum;
+}
+
+int count(int *items, int len) {
+    int acc = 0;
+    for (int k = 0; k < len; ++k)
+        acc += items[k];
+    return acc;
+}
+
+int other(int *items, int len) {
+    int acc = 1;
+    for (int k = 0; k < len; k++)
+        acc *= items[k];
+    return acc;
+}
+"""
+
+
+class TestStructuralHash(unittest.TestCase):
+    def test_renamed_clone(self):
+        tu = get_tu(kSource)
+        total = get_cursor(tu, 'total')
+        count = get_cursor(tu, 'count')
+        other = get_cursor(tu, 'other')
+
+        self.assertNotEqual(total.get_structural_hash(), 0)
+        self.assertEqual(total.get_structural_hash(), count.get_structural_hash())
+        self.assertNotEqual(total.get_structural_hash(), other.get_structural_hash())
+        self.assertNotEqual(total.get_structural_hash(identifiers=True),
+                            count.get_structural_hash(identifiers=True))
+
+    def test_literals(self):
+        tu = get_tu('int f() { return 1; }\nint g() { return 2; }\n')
+        f = get_cursor(tu, 'f')
+        g = get_cursor(tu, 'g')
+
+        self.assertEqual(f.get_structural_hash(), g.get_structural_hash())
+        self.assertNotEqual(f.get_structural_hash(literals=True),
+                            g.get_structural_hash(literals=True))
+
+    def test_no_body(self):
+        tu = get_tu('int f(int);')
+        self.assertEqual(get_cursor(tu, 'f').get_structural_hash(), 0)
+
+    def test_subtree_hashes(self):
+        tu = get_tu(kSource)
+        hashes = tu.get_subtree_hashes(min_size=5)
+
+        self.assertEqual(hashes.files, ['t.c'])
+        records = list(hashes.records)
+        self.assertTrue(all(r.size >= 5 for r in records))
+
+        bodies = [r for r in records if r.kind == CursorKind.COMPOUND_STMT]
+        self.assertEqual([r.line for r in bodies], [1, 8, 15])
+        self.assertEqual(bodies[0].hash, bodies[1].hash)
+
+        index = records.index(bodies[1])
+        cursor = hashes.get_cursor(index)
+        self.assertEqual(cursor.kind, CursorKind.COMPOUND_STMT)
+        self.assertEqual(cursor.get_structural_hash(), bodies[1].hash)
+
+    def test_clone_index(self):
+        index = CloneIndex()
+        index.add(get_tu(kSource), min_size=5)
+        index.add(get_tu(kSource, lang='cpp'), min_size=5)
+
+        self.assertEqual(index.files, ['t.c', 't.cpp'])
+        loops = [bucket for bucket in index.get_buckets()
+                 if bucket[0].kind == CursorKind.FOR_STMT]
+        self.assertEqual(len(loops), 1)
+        self.assertEqual(sorted((r.file, r.line) for r in loops[0]),
+                         [(0, 3), (0, 10), (1, 3), (1, 10)])
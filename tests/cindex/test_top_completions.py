@@ -0,0 +1,54 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import CursorKind
+from clang.cindex import TranslationUnit
+
+import unittest
+
+
+kSource = """
+int max_value(int a, int b);
+int min_value(int a, int b);
+int maxValue;
+double mixed_average;
+
+void f() {
+
+}
+"""
+
+
+class TestTopCompletions(unittest.TestCase):
+    def complete(self, prefix, limit=50):
+        files = [('fake.c', kSource)]
+        tu = TranslationUnit.from_source('fake.c', ['-std=c99'], unsaved_files=files)
+        return tu.complete('fake.c', 8, 1, prefix, limit, unsaved_files=files)
+
+    def test_prefix(self):
+        results = self.complete('max')
+
+        self.assertGreater(results.num_candidates, len(results))
+        self.assertEqual([c.typed_text for c in results][:2], ['maxValue', 'max_value'])
+        self.assertNotIn('min_value', [c.typed_text for c in results])
+
+    def test_rendering(self):
+        completion = next(c for c in self.complete('max_value')
+                          if c.typed_text == 'max_value')
+
+        self.assertEqual(completion.kind, CursorKind.FUNCTION_DECL)
+        self.assertEqual(completion.result_type, 'int')
+        self.assertEqual(completion.signature, 'max_value(int a, int b)')
+
+    def test_fuzzy(self):
+        typed = [c.typed_text for c in self.complete('mv')]
+
+        # Word-boundary matches rank first.
+        self.assertEqual(typed[:3], ['maxValue', 'max_value', 'min_value'])
+        self.assertIn('mixed_average', typed)
+
+    def test_limit(self):
+        self.assertEqual(len(self.complete('', limit=2)), 2)
+        self.assertEqual(len(self.complete('zzz')), 0)
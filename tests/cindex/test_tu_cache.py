@@ -0,0 +1,66 @@
+import os
+from clang.cindex import Config
+if 'CLANG_LIBRARY_PATH' in os.environ:
+    Config.set_library_path(os.environ['CLANG_LIBRARY_PATH'])
+
+from clang.cindex import TranslationUnitCache
+
+import io
+import tempfile
+import unittest
+from .util import get_cursor
+from .util import get_tu
+
+
+class TestResourceUsage(unittest.TestCase):
+    def test_usage(self):
+        usage = get_tu('int x;\nint f(void) { return x; }\n').get_resource_usage()
+
+        self.assertGreater(usage.ast, 0)
+        self.assertGreater(usage.identifiers, 0)
+        self.assertGreater(usage.source_manager, 0)
+        self.assertEqual(usage.total, sum(usage.entries.values()))
+        self.assertLessEqual(usage.resident, usage.total)
+
+
+class TestTranslationUnitCache(unittest.TestCase):
+    def unsaved(self, name, value):
+        return [(name, 'int %s(void) { return %d; }\n' % (name[0], value))]
+
+    def test_hit_and_content_change(self):
+        cache = TranslationUnitCache(budget=1 << 30)
+        tu = cache.get('a.c', unsaved_files=self.unsaved('a.c', 1))
+
+        self.assertIs(cache.get('a.c', unsaved_files=self.unsaved('a.c', 1)), tu)
+        self.assertIsNot(cache.get('a.c', unsaved_files=self.unsaved('a.c', 2)), tu)
+        self.assertIsNot(cache.get('a.c', ['-DX'], self.unsaved('a.c', 1)), tu)
+        self.assertEqual((cache.hits, cache.misses, len(cache)), (1, 3, 3))
+
+    def test_file_like_unsaved_files(self):
+        cache = TranslationUnitCache(budget=1 << 30)
+        (name, contents), = self.unsaved('a.c', 1)
+        tu = cache.get('a.c', unsaved_files=[(name, io.StringIO(contents))])
+
+        self.assertIsNotNone(get_cursor(tu, 'a'))
+        self.assertIs(cache.get('a.c', unsaved_files=[(name, contents)]), tu)
+
+    def test_eviction(self):
+        cache = TranslationUnitCache(budget=1)
+        cache.get('a.c', unsaved_files=self.unsaved('a.c', 1))
+        tu = cache.get('b.c', unsaved_files=self.unsaved('b.c', 1))
+
+        # The requested unit stays even when over budget.
+        self.assertEqual(len(cache), 1)
+        self.assertEqual(cache.size, tu.get_resource_usage().resident)
+        self.assertIs(cache.get('b.c', unsaved_files=self.unsaved('b.c', 1)), tu)
+
+    def test_save_evicted(self):
+        with tempfile.TemporaryDirectory() as save_dir:
+            cache = TranslationUnitCache(budget=1, save_dir=save_dir)
+            cache.get('a.c', unsaved_files=self.unsaved('a.c', 1))
+            cache.get('b.c', unsaved_files=self.unsaved('b.c', 1))
+            self.assertEqual(len(os.listdir(save_dir)), 1)
+
+            tu = cache.get('a.c', unsaved_files=self.unsaved('a.c', 1))
+            self.assertEqual(cache.loads, 1)
+            self.assertIsNotNone(get_cursor(tu, 'a'))